@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "../placement.h"
+
+// Measurement harness shared by primitives.cpp and layout.cpp.
+//
+// run<Primitive>(threads, warmup, duration) constructs Primitive(threads) and has every
+// thread call op(tid) in a loop: first for the warm-up, which is discarded, then for the
+// measured phase. Threads are pinned in compact order, so the two threads of a ping-pong
+// share as much cache as the machine allows. Cycles and cache misses come from
+// perf_event_open when the kernel allows it (see /proc/sys/kernel/perf_event_paranoid).
+// wake() is called until every thread has left op(), for primitives that can sleep.
+
+namespace harness {
+
+using Clock = std::chrono::steady_clock;
+
+// Per-thread hardware counters; fd == -1 when perf_event_open is unavailable
+class PerfCounters {
+    int cycles_fd = -1;
+    int misses_fd = -1;
+
+    static int open_counter(uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    static long long read_counter(int fd) {
+        long long value = 0;
+        if (fd == -1 || ::read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+        return value;
+    }
+
+public:
+    PerfCounters() : cycles_fd(open_counter(PERF_COUNT_HW_CPU_CYCLES)), misses_fd(open_counter(PERF_COUNT_HW_CACHE_MISSES)) {}
+
+    ~PerfCounters() {
+        if (cycles_fd != -1) close(cycles_fd);
+        if (misses_fd != -1) close(misses_fd);
+    }
+
+    void start() {
+        for (int fd : {cycles_fd, misses_fd}) {
+            if (fd == -1) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop() {
+        for (int fd : {cycles_fd, misses_fd}) {
+            if (fd != -1) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    long long cycles() const { return read_counter(cycles_fd); }
+    long long cache_misses() const { return read_counter(misses_fd); }
+};
+
+// Pins the calling thread to the index-th CPU in compact order
+inline void pin_to_cpu(int index) {
+    static const std::vector<int> order = placement::Topology::read().compact_order();
+    if (!order.empty()) placement::pin(pthread_self(), order[index % order.size()]);
+}
+
+enum Phase { WARMUP = 0, MEASURE = 1, DONE = 2 };
+
+struct Result {
+    long long ops = 0;
+    long long cycles = 0;        // -1 if not available
+    long long cache_misses = 0;  // -1 if not available
+    double seconds = 0;
+
+    double ns_per_op(int threads) const { return ops ? seconds * 1e9 * threads / ops : 0; }
+};
+
+template <typename Primitive>
+Result run(int threads, std::chrono::milliseconds warmup, std::chrono::milliseconds duration) {
+    Primitive primitive(threads);
+    std::atomic<int> phase{WARMUP};
+    std::atomic<int> finished{0};
+    std::vector<long long> ops(threads, 0), cycles(threads, 0), misses(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (int tid = 0; tid < threads; tid++) {
+        workers.emplace_back([&, tid] {
+            pin_to_cpu(tid);
+            PerfCounters counters;
+
+            while (phase.load(std::memory_order_relaxed) == WARMUP) {
+                primitive.op(tid);
+            }
+
+            long long count = 0;
+            counters.start();
+            while (phase.load(std::memory_order_relaxed) == MEASURE) {
+                primitive.op(tid);
+                count++;
+            }
+            counters.stop();
+
+            ops[tid] = count;
+            cycles[tid] = counters.cycles();
+            misses[tid] = counters.cache_misses();
+            finished++;
+        });
+    }
+
+    std::this_thread::sleep_for(warmup);
+    auto start = Clock::now();
+    phase = MEASURE;
+    std::this_thread::sleep_for(duration);
+    phase = DONE;
+    auto end = Clock::now();
+
+    while (finished < threads) {
+        primitive.wake();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (auto& t : workers) t.join();
+
+    Result result;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    for (int tid = 0; tid < threads; tid++) {
+        result.ops += ops[tid];
+        result.cycles = (cycles[tid] < 0 || result.cycles < 0) ? -1 : result.cycles + cycles[tid];
+        result.cache_misses = (misses[tid] < 0 || result.cache_misses < 0) ? -1 : result.cache_misses + misses[tid];
+    }
+    return result;
+}
+
+}  // namespace harness
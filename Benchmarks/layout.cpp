@@ -0,0 +1,221 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "../layout.h"
+#include "../queue_locks.h"
+#include "harness.h"
+
+// Coherence cost of the state layouts the dining philosophers programs can be built with
+// (-DLAYOUT=LAYOUT_PACKED / LAYOUT_PADDED / LAYOUT_SPLIT). The tables come from layout.h,
+// the same templates the programs instantiate, and every layout of every engine runs here
+// side by side with one thread per philosopher, so false sharing between neighbours shows
+// up as extra cycles and cache misses per operation. The exclusive lock and condition
+// variable follow -DEXCLUSIVE_LOCK as in the programs.
+//
+// For a line-level view of the same runs, use perf on this binary, e.g.
+//   perf stat -e cycles,cache-misses,L1-dcache-load-misses ./layout
+//   perf c2c record ./layout && perf c2c report
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+std::mutex cout_mutex;
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    std::cout << "\033[" << color << "m" << message << "\033[0m" << std::endl;
+}
+
+// ---------------------------------------------------------------------------------------
+// Engines, one per program, parameterised on the layout
+
+// chandy-misra.cpp: each thread works its own fork, as a philosopher does between requests
+template <int L>
+class ChandyMisraForks {
+    class sync_channel {
+        std::mutex mutex;
+        std::condition_variable cv;
+
+    public:
+        void notifyall() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.notify_all();
+        }
+    };
+
+    layout::ForkTable<L, queue_locks::ExclusiveLock, sync_channel> forks;
+
+public:
+    explicit ChandyMisraForks(int threads) : forks(threads) {
+        for (int i = 0; i < threads; i++) forks.owner(i) = 0;
+    }
+
+    // fork::request + done_using, with tid + 1 as the philosopher
+    void op(int tid) {
+        int& owner = forks.owner(tid);
+        bool& dirty = forks.dirty(tid);
+        while (owner != tid + 1) {
+            if (dirty) {
+                std::lock_guard<queue_locks::ExclusiveLock> lock(forks.mutex(tid));
+                dirty = false;
+                owner = tid + 1;
+            }
+        }
+        {
+            std::lock_guard<queue_locks::ExclusiveLock> lock(forks.mutex(tid));
+        }
+        dirty = true;
+        forks.channel(tid).notifyall();
+    }
+
+    void wake() {}
+};
+
+// dijkstra-tannenbaum.cpp: take_fork/put_fork under the table mutex
+template <int L>
+class DijkstraTable {
+    static constexpr int THINKING = 2;
+    static constexpr int HUNGRY = 1;
+    static constexpr int EATING = 0;
+
+    const int n;
+    layout::PhilosopherTable<L, queue_locks::ExclusiveCondition> table;
+    layout::Cell<L, queue_locks::ExclusiveLock> mtx;   // CACHE_ALIGNED in the program
+    std::atomic<bool> should_terminate{false};
+
+    int left(int phnum) const { return (phnum + n - 1) % n; }
+    int right(int phnum) const { return (phnum + 1) % n; }
+
+    void test(int phnum) {
+        if (table.state(phnum) == HUNGRY && table.state(left(phnum)) != EATING && table.state(right(phnum)) != EATING) {
+            table.state(phnum) = EATING;
+            table.cv(phnum).notify_one();
+        }
+    }
+
+public:
+    explicit DijkstraTable(int threads) : n(std::max(threads, 2)), table(n, THINKING) {}
+
+    void op(int phnum) {
+        {
+            std::unique_lock<queue_locks::ExclusiveLock> lock(mtx.value);
+            table.state(phnum) = HUNGRY;
+            test(phnum);
+            while (table.state(phnum) != EATING && !should_terminate) {
+                table.cv(phnum).wait_for(lock, std::chrono::milliseconds(100));
+            }
+        }
+        {
+            std::unique_lock<queue_locks::ExclusiveLock> lock(mtx.value);
+            table.state(phnum) = THINKING;
+            test(left(phnum));
+            test(right(phnum));
+        }
+    }
+
+    void wake() { should_terminate = true; }
+};
+
+// queue.cpp: chopstick flags under the table mutex, and one wakeup per philosopher that the
+// grant is handed over in. The grant and the release serialize on the table mutex; the owner
+// consumes its grant under its own wakeup mutex, so neighbours' wakeups sharing a line (packed)
+// cost coherence traffic that is not hidden behind the table mutex.
+template <int L>
+class QueueTable {
+    struct Wakeup {
+        std::mutex m;
+        std::condition_variable cv;
+        bool granted = false;
+    };
+
+    const int n;
+    layout::FlagArray<L> chopsticks;
+    std::vector<layout::Cell<L, Wakeup>> wakeups;
+    layout::Cell<L, std::mutex> mtx;   // CACHE_ALIGNED in the program
+
+public:
+    explicit QueueTable(int threads) : n(std::max(threads, 2)), chopsticks(n, true), wakeups(n) {}
+
+    void op(int id) {
+        int leftChopstick = id;
+        int rightChopstick = (id + 1) % n;
+        Wakeup& w = wakeups[id].value;
+        {
+            std::unique_lock<std::mutex> lock(mtx.value);
+            if (!chopsticks[leftChopstick] || !chopsticks[rightChopstick]) return;
+            chopsticks[leftChopstick] = false;
+            chopsticks[rightChopstick] = false;
+            {
+                std::lock_guard<std::mutex> grant(w.m);
+                w.granted = true;
+            }
+            w.cv.notify_one();
+        }
+        {
+            std::unique_lock<std::mutex> lock(w.m);
+            w.granted = false;
+        }
+        {
+            std::unique_lock<std::mutex> lock(mtx.value);
+            chopsticks[leftChopstick] = true;
+            chopsticks[rightChopstick] = true;
+        }
+    }
+
+    void wake() {}
+};
+
+// ---------------------------------------------------------------------------------------
+// Output
+
+void print_row(const std::string& engine, int layout, int threads, const harness::Result& r) {
+    double ns_per_op = r.ns_per_op(threads);
+
+    std::ostringstream row;
+    row << std::left << std::setw(14) << engine << std::setw(10) << layout::name(layout)
+        << std::right << std::setw(8) << threads
+        << std::setw(12) << std::fixed << std::setprecision(1) << ns_per_op;
+    if (r.cycles >= 0 && r.ops) row << std::setw(12) << std::setprecision(1) << (double)r.cycles / r.ops;
+    else row << std::setw(12) << "n/a";
+    if (r.cache_misses >= 0 && r.ops) row << std::setw(14) << std::setprecision(3) << (double)r.cache_misses / r.ops;
+    else row << std::setw(14) << "n/a";
+
+    atomicPrint(row.str(), layout == LAYOUT_PACKED ? YELLOW : GREEN);
+}
+
+template <template <int> class Engine>
+void bench(const std::string& engine, int threads, std::chrono::milliseconds warmup, std::chrono::milliseconds duration) {
+    print_row(engine, LAYOUT_PACKED, threads, harness::run<Engine<LAYOUT_PACKED>>(threads, warmup, duration));
+    print_row(engine, LAYOUT_PADDED, threads, harness::run<Engine<LAYOUT_PADDED>>(threads, warmup, duration));
+    print_row(engine, LAYOUT_SPLIT, threads, harness::run<Engine<LAYOUT_SPLIT>>(threads, warmup, duration));
+}
+
+// Usage: layout [threads] [milliseconds-per-run]
+int main(int argc, char* argv[]) {
+    int hardware = std::thread::hardware_concurrency();
+    int threads = argc > 1 ? std::stoi(argv[1]) : std::max(hardware, 4);
+    std::chrono::milliseconds duration(argc > 2 ? std::stoi(argv[2]) : 1000);
+    std::chrono::milliseconds warmup(duration / 5);
+
+    std::ostringstream header;
+    header << std::left << std::setw(14) << "engine" << std::setw(10) << "layout"
+           << std::right << std::setw(8) << "threads" << std::setw(12) << "ns/op"
+           << std::setw(12) << "cycles/op" << std::setw(14) << "misses/op";
+    atomicPrint(header.str(), CYAN);
+
+    bench<ChandyMisraForks>("chandy-misra", threads, warmup, duration);
+    bench<DijkstraTable>("dijkstra", threads, warmup, duration);
+    bench<QueueTable>("queue", threads, warmup, duration);
+
+    atomicPrint("Benchmark complete!", MAGENTA);
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <map>
+
+#include "../placement.h"
+
+// Handoff latency around a ring of actors under each placement policy.
+// A token goes round the table: actor i waits for it, then hands it to actor i + 1, the
+// same neighbour-to-neighbour handoff a released fork makes. Two handoff mechanisms:
+//   spin    - each actor polls its own cache-line-sized flag (pure cache-to-cache latency)
+//   condvar - each actor sleeps on its own mutex/condition variable (as the programs do)
+// Each row also shows where the policy puts the ring: how many handoffs, n-1 -> 0 included,
+// cross L3 domains, and how many physical cores it occupies.
+
+using Clock = std::chrono::steady_clock;
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+std::mutex cout_mutex;
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    std::cout << "\033[" << color << "m" << message << "\033[0m" << std::endl;
+}
+
+struct alignas(64) Seat {
+    std::atomic<bool> has_token{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+struct Footprint {
+    int l3_crossings = 0;
+    int cores = 0;
+};
+
+// Where the ring lands; empty for NONE, which leaves it to the scheduler
+Footprint footprint(placement::Policy policy, const placement::Topology& topology, int actors) {
+    Footprint result;
+    if (policy == placement::Policy::NONE) return result;
+
+    std::map<int, placement::Cpu> by_id;
+    for (const placement::Cpu& cpu : topology.cpus) by_id[cpu.id] = cpu;
+    std::vector<std::pair<int, int>> cores;
+    for (int i = 0; i < actors; i++) {
+        const placement::Cpu& mine = by_id[placement::cpu_for(policy, topology, i, actors)];
+        const placement::Cpu& next = by_id[placement::cpu_for(policy, topology, (i + 1) % actors, actors)];
+        result.l3_crossings += mine.package != next.package || mine.l3 != next.l3;
+        cores.push_back({mine.package, mine.core});
+    }
+    std::sort(cores.begin(), cores.end());
+    result.cores = std::unique(cores.begin(), cores.end()) - cores.begin();
+    return result;
+}
+
+// Returns the mean handoff latency in nanoseconds
+double run(placement::Policy policy, const placement::Topology& topology, bool spin, int actors, std::chrono::milliseconds duration) {
+    std::unique_ptr<Seat[]> seats(new Seat[actors]);
+    std::atomic<bool> done{false};
+    std::atomic<long long> handoffs{0};
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < actors; i++) {
+        threads.emplace_back([&, i] {
+            Seat& mine = seats[i];
+            Seat& next = seats[(i + 1) % actors];
+            long long count = 0;
+
+            while (!done) {
+                if (spin) {
+                    while (!mine.has_token.load(std::memory_order_acquire) && !done) {
+                        std::this_thread::yield();
+                    }
+                    if (done) break;
+                    mine.has_token.store(false, std::memory_order_relaxed);
+                    next.has_token.store(true, std::memory_order_release);
+                } else {
+                    {
+                        std::unique_lock<std::mutex> lock(mine.mutex);
+                        mine.cv.wait(lock, [&] { return mine.has_token.load() || done; });
+                        if (done) break;
+                        mine.has_token = false;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(next.mutex);
+                        next.has_token = true;
+                    }
+                    next.cv.notify_one();
+                }
+                count++;
+            }
+            handoffs += count;
+        });
+        placement::pin(threads.back().native_handle(), placement::cpu_for(policy, topology, i, actors));
+    }
+
+    auto start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(seats[0].mutex);
+        seats[0].has_token = true;
+    }
+    seats[0].cv.notify_one();
+    std::this_thread::sleep_for(duration);
+    done = true;
+    double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    for (int i = 0; i < actors; i++) {
+        {
+            std::lock_guard<std::mutex> lock(seats[i].mutex);
+        }
+        seats[i].cv.notify_all();
+    }
+    for (auto& t : threads) t.join();
+
+    return handoffs ? elapsed / handoffs : 0;
+}
+
+// Usage: placement [milliseconds-per-run] [actors...]
+// By default the ring is run with half as many actors as CPUs, as many, and twice as many.
+int main(int argc, char* argv[]) {
+    placement::Topology topology = placement::Topology::read();
+    int cpus = topology.cpus.size();
+    std::chrono::milliseconds duration(argc > 1 ? std::stoi(argv[1]) : 1000);
+    std::vector<int> actor_counts;
+    for (int i = 2; i < argc; i++) actor_counts.push_back(std::stoi(argv[i]));
+    if (actor_counts.empty()) {
+        for (int actors : {std::max(cpus / 2, 2), std::max(cpus, 2), std::max(2 * cpus, 4)}) {
+            if (std::find(actor_counts.begin(), actor_counts.end(), actors) == actor_counts.end()) {
+                actor_counts.push_back(actors);
+            }
+        }
+    }
+
+    atomicPrint("Topology: " + std::to_string(cpus) + " CPUs, " + std::to_string(topology.l3_domains())
+                + " L3 domain(s)", YELLOW);
+
+    std::ostringstream header;
+    header << std::left << std::setw(12) << "policy" << std::right << std::setw(8) << "actors"
+           << std::setw(16) << "spin ns/handoff" << std::setw(20) << "condvar ns/handoff"
+           << std::setw(12) << "L3 hops" << std::setw(8) << "cores";
+    atomicPrint(header.str(), CYAN);
+
+    for (int actors : actor_counts) {
+        for (placement::Policy policy : {placement::Policy::NONE, placement::Policy::COMPACT,
+                                         placement::Policy::SCATTER, placement::Policy::NEIGHBOR}) {
+            double spin = run(policy, topology, true, actors, duration);
+            double condvar = run(policy, topology, false, actors, duration);
+            Footprint where = footprint(policy, topology, actors);
+
+            std::ostringstream row;
+            row << std::left << std::setw(12) << placement::policy_name(policy) << std::right << std::setw(8) << actors
+                << std::fixed << std::setprecision(1) << std::setw(16) << spin << std::setw(20) << condvar;
+            if (policy == placement::Policy::NONE) row << std::setw(12) << "-" << std::setw(8) << "-";
+            else row << std::setw(12) << where.l3_crossings << std::setw(8) << where.cores;
+            atomicPrint(row.str(), policy == placement::Policy::NONE ? YELLOW : GREEN);
+        }
+    }
+
+    atomicPrint("Benchmark complete!", MAGENTA);
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "../queue_locks.h"
+#include "harness.h"
+
+// Microbenchmarks for the synchronization primitives used by the simulations.
+// Each primitive is a copy of the one in its program with the console output removed,
+// so what is measured is the locking protocol itself and nothing else. The exclusive lock
+// the programs can swap (-DEXCLUSIVE_LOCK) is a template parameter here, and every
+// primitive is measured with std::mutex and with the MCS and CLH locks of queue_locks.h.
+//
+// Every primitive runs in three modes:
+//   uncontended - one thread
+//   ping-pong   - two threads on the same primitive, bouncing its cache lines
+//   saturation  - N threads on the same primitive
+// The harness (harness.h) pins threads, discards a warm-up phase, and reads cycles / cache
+// misses from perf_event_open when the kernel allows it.
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+std::mutex cout_mutex;
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    std::cout << "\033[" << color << "m" << message << "\033[0m" << std::endl;
+}
+
+// ---------------------------------------------------------------------------------------
+// Primitives under test
+
+// fork::request + done_using from chandy-misra.cpp (one meal's worth of work on one fork)
+template <typename Lock>
+class ChandyMisraFork {
+    class sync_channel {
+        std::mutex mutex;
+        std::condition_variable cv;
+
+    public:
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock);
+        }
+
+        void notifyall() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.notify_all();
+        }
+    };
+
+    int owner = 1;
+    bool dirty = true;
+    Lock mutex;
+    sync_channel channel;
+
+    void request(int const ownerId) {
+        while (owner != ownerId) {
+            if (dirty) {
+                std::lock_guard<Lock> lock(mutex);
+                dirty = false;
+                owner = ownerId;
+            } else {
+                channel.wait();
+            }
+        }
+    }
+
+    void done_using() {
+        dirty = true;
+        channel.notifyall();
+    }
+
+public:
+    explicit ChandyMisraFork(int) {}
+
+    // Each thread alternates between two owner ids, so even the uncontended row pays for the
+    // dirty check and the hand-over on every op, as a philosopher does after its neighbour ate
+    void op(int tid) {
+        static thread_local bool second_seat = false;
+        second_seat = !second_seat;
+        request(2 * tid + 1 + second_seat);
+        {
+            std::lock_guard<Lock> lock(mutex);
+        }
+        done_using();
+    }
+
+    // request() can miss a notification and sleep forever once the other threads stop
+    void wake() { channel.notifyall(); }
+};
+
+// take_fork + put_fork from dijkstra-tannenbaum.cpp, one philosopher per thread
+template <typename Lock>
+class DijkstraTable {
+    static constexpr int THINKING = 2;
+    static constexpr int HUNGRY = 1;
+    static constexpr int EATING = 0;
+
+    const int n;
+    std::vector<int> state;
+    Lock mtx;
+    std::unique_ptr<queue_locks::ConditionFor<Lock>[]> cv;
+    std::atomic<bool> should_terminate{false};
+
+    int left(int phnum) const { return (phnum + n - 1) % n; }
+    int right(int phnum) const { return (phnum + 1) % n; }
+
+    void test(int phnum) {
+        if (state[phnum] == HUNGRY && state[left(phnum)] != EATING && state[right(phnum)] != EATING) {
+            state[phnum] = EATING;
+            cv[phnum].notify_one();
+        }
+    }
+
+    void take_fork(int phnum) {
+        std::unique_lock<Lock> lock(mtx);
+        state[phnum] = HUNGRY;
+        test(phnum);
+        while (state[phnum] != EATING && !should_terminate) {
+            cv[phnum].wait_for(lock, std::chrono::milliseconds(100));
+        }
+    }
+
+    void put_fork(int phnum) {
+        std::unique_lock<Lock> lock(mtx);
+        state[phnum] = THINKING;
+        test(left(phnum));
+        test(right(phnum));
+    }
+
+public:
+    // A table with one seat per thread, but never fewer than the program's five
+    explicit DijkstraTable(int threads) : n(std::max(threads, 5)), state(n, THINKING), cv(new queue_locks::ConditionFor<Lock>[n]) {}
+
+    void op(int tid) {
+        take_fork(tid);
+        put_fork(tid);
+    }
+
+    void wake() { should_terminate = true; }
+};
+
+// One reader entry/exit from reader-first.cpp
+template <typename Lock>
+class ReaderFirstRead {
+    Lock resource_mutex;
+    std::mutex reader_count_mutex;
+    int reader_count = 0;
+
+public:
+    explicit ReaderFirstRead(int) {}
+
+    void op(int) {
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            reader_count++;
+            if (reader_count == 1) {
+                resource_mutex.lock();
+            }
+        }
+        {
+            // As in reader-first.cpp, the last reader out unlocks for the first reader in
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            reader_count--;
+            if (reader_count == 0) {
+                resource_mutex.unlock();
+            }
+        }
+    }
+
+    void wake() {}
+};
+
+// One writer entry/exit from reader-first.cpp
+template <typename Lock>
+class ReaderFirstWrite {
+    Lock resource_mutex;
+    int shared_memory = 0;
+
+public:
+    explicit ReaderFirstWrite(int) {}
+
+    void op(int) {
+        resource_mutex.lock();
+        shared_memory += 1;
+        resource_mutex.unlock();
+    }
+
+    void wake() {}
+};
+
+// ---------------------------------------------------------------------------------------
+// Output
+
+void print_row(const std::string& primitive, const std::string& mode, int threads, const harness::Result& r) {
+    double ns_per_op = r.ns_per_op(threads);
+    double mops = r.ops / r.seconds / 1e6;
+
+    std::ostringstream row;
+    row << std::left << std::setw(38) << primitive << std::setw(13) << mode
+        << std::right << std::setw(8) << threads
+        << std::setw(12) << std::fixed << std::setprecision(1) << ns_per_op
+        << std::setw(10) << std::setprecision(3) << mops;
+    if (r.cycles >= 0 && r.ops) row << std::setw(12) << std::setprecision(1) << (double)r.cycles / r.ops;
+    else row << std::setw(12) << "n/a";
+    if (r.cache_misses >= 0 && r.ops) row << std::setw(14) << std::setprecision(3) << (double)r.cache_misses / r.ops;
+    else row << std::setw(14) << "n/a";
+
+    atomicPrint(row.str(), mode == "uncontended" ? GREEN : mode == "ping-pong" ? YELLOW : RED);
+}
+
+template <typename Primitive>
+void bench_one(const std::string& name, int saturation_threads, std::chrono::milliseconds warmup, std::chrono::milliseconds duration) {
+    print_row(name, "uncontended", 1, harness::run<Primitive>(1, warmup, duration));
+    print_row(name, "ping-pong", 2, harness::run<Primitive>(2, warmup, duration));
+    print_row(name, "saturation", saturation_threads, harness::run<Primitive>(saturation_threads, warmup, duration));
+}
+
+template <template <typename> class Primitive>
+void bench(const std::string& name, int saturation_threads, std::chrono::milliseconds warmup, std::chrono::milliseconds duration) {
+    bench_one<Primitive<std::mutex>>(name + " [std::mutex]", saturation_threads, warmup, duration);
+    bench_one<Primitive<queue_locks::McsLock>>(name + " [mcs]", saturation_threads, warmup, duration);
+    bench_one<Primitive<queue_locks::ClhLock>>(name + " [clh]", saturation_threads, warmup, duration);
+}
+
+// Usage: primitives [saturation-threads] [milliseconds-per-run]
+int main(int argc, char* argv[]) {
+    int hardware = std::thread::hardware_concurrency();
+    int saturation_threads = argc > 1 ? std::stoi(argv[1]) : std::max(hardware, 4);
+    std::chrono::milliseconds duration(argc > 2 ? std::stoi(argv[2]) : 1000);
+    std::chrono::milliseconds warmup(duration / 5);
+
+    std::ostringstream header;
+    header << std::left << std::setw(38) << "primitive" << std::setw(13) << "mode"
+           << std::right << std::setw(8) << "threads" << std::setw(12) << "ns/op"
+           << std::setw(10) << "Mops/s" << std::setw(12) << "cycles/op" << std::setw(14) << "misses/op";
+    atomicPrint(header.str(), CYAN);
+
+    bench<ChandyMisraFork>("chandy-misra fork", saturation_threads, warmup, duration);
+    bench<DijkstraTable>("dijkstra take/put_fork", saturation_threads, warmup, duration);
+    bench<ReaderFirstRead>("reader-first read", saturation_threads, warmup, duration);
+    bench<ReaderFirstWrite>("reader-first write", saturation_threads, warmup, duration);
+
+    atomicPrint("Benchmark complete!", MAGENTA);
+    return 0;
+}
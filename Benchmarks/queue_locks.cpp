@@ -0,0 +1,138 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "../placement.h"
+#include "../queue_locks.h"
+
+// Throughput and fairness of the exclusive locks the programs can be built with
+// (-DEXCLUSIVE_LOCK=...): std::mutex against the MCS and CLH queue locks.
+// Every thread loops on: take the lock, update a few shared counters (the critical section),
+// release it, then do some private work before the next acquisition.
+// Fairness is reported as Jain's index over the per-thread operation counts (1.0 = everyone
+// got the same share) and as the ratio between the least and the most served thread.
+// Threads are placed according to PLACEMENT, as in the programs.
+
+using Clock = std::chrono::steady_clock;
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+std::mutex cout_mutex;
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    std::cout << "\033[" << color << "m" << message << "\033[0m" << std::endl;
+}
+
+// Shared data touched inside the critical section, on its own lines so that only the lock
+// protocol and the data themselves move between caches
+struct alignas(64) SharedData {
+    long long counters[8] = {};
+};
+
+struct Result {
+    double mops = 0;
+    double jain = 0;
+    double min_max = 0;
+};
+
+// Private work between two acquisitions, roughly a few hundred nanoseconds
+inline unsigned local_work(unsigned seed) {
+    for (int i = 0; i < 64; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+    }
+    return seed;
+}
+
+template <typename Lock>
+Result run(int threads, std::chrono::milliseconds duration) {
+    Lock lock;
+    SharedData data;
+    std::atomic<bool> start{false};
+    std::atomic<bool> done{false};
+    std::vector<long long> ops(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (int tid = 0; tid < threads; tid++) {
+        workers.emplace_back([&, tid] {
+            unsigned seed = tid + 1;
+            long long count = 0;
+            while (!start) std::this_thread::yield();
+
+            while (!done.load(std::memory_order_relaxed)) {
+                {
+                    std::lock_guard<Lock> guard(lock);
+                    for (long long& counter : data.counters) counter++;
+                }
+                seed = local_work(seed);
+                count++;
+            }
+            ops[tid] = count + (seed == 0);  // Keeps local_work from being optimised away
+        });
+        placement::place(workers.back(), tid, threads);
+    }
+
+    auto begin = Clock::now();
+    start = true;
+    std::this_thread::sleep_for(duration);
+    done = true;
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    for (auto& t : workers) t.join();
+
+    double sum = 0, sum_squares = 0;
+    for (long long count : ops) {
+        sum += count;
+        sum_squares += (double)count * count;
+    }
+    auto [least, most] = std::minmax_element(ops.begin(), ops.end());
+
+    Result result;
+    result.mops = sum / seconds / 1e6;
+    result.jain = sum_squares ? sum * sum / (threads * sum_squares) : 0;
+    result.min_max = *most ? (double)*least / *most : 0;
+    return result;
+}
+
+void print_row(const std::string& lock, int threads, const Result& r, Color color) {
+    std::ostringstream row;
+    row << std::left << std::setw(12) << lock << std::right << std::setw(8) << threads
+        << std::fixed << std::setw(10) << std::setprecision(3) << r.mops
+        << std::setw(10) << std::setprecision(3) << r.jain
+        << std::setw(10) << std::setprecision(3) << r.min_max;
+    atomicPrint(row.str(), color);
+}
+
+// Usage: queue_locks [milliseconds-per-run] [threads...]
+int main(int argc, char* argv[]) {
+    std::chrono::milliseconds duration(argc > 1 ? std::stoi(argv[1]) : 1000);
+    std::vector<int> thread_counts;
+    for (int i = 2; i < argc; i++) thread_counts.push_back(std::stoi(argv[i]));
+    if (thread_counts.empty()) thread_counts = {2, 4, 8, 16, 32, 64, 128};
+
+    atomicPrint(std::to_string(std::thread::hardware_concurrency()) + " hardware threads, placement "
+                + placement::policy_name(placement::policy_from_env()), YELLOW);
+
+    std::ostringstream header;
+    header << std::left << std::setw(12) << "lock" << std::right << std::setw(8) << "threads"
+           << std::setw(10) << "Mops/s" << std::setw(10) << "jain" << std::setw(10) << "min/max";
+    atomicPrint(header.str(), CYAN);
+
+    for (int threads : thread_counts) {
+        print_row("std::mutex", threads, run<std::mutex>(threads, duration), YELLOW);
+        print_row("mcs", threads, run<queue_locks::McsLock>(threads, duration), GREEN);
+        print_row("clh", threads, run<queue_locks::ClhLock>(threads, duration), GREEN);
+    }
+
+    atomicPrint("Benchmark complete!", MAGENTA);
+    return 0;
+}
@@ -0,0 +1,416 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include "../queue_locks.h"
+
+// Read-mostly, conditional-update workload for the upgradable read lock.
+// Readers only read. Updaters read shared_memory, decide whether to update it from the
+// value they saw, and then either
+//   upgrade - convert their read hold into a write hold in place, or
+//   requeue - drop the read hold and queue up as an ordinary writer.
+// With requeue the value may have changed by the time the writer gets in, so the decision
+// was made on an old value; those are counted as stale decisions. Readers pause between
+// reads for four times the critical section, as the programs' readers sleep between reads;
+// with back-to-back readers, reader preference would starve a requeued writer outright.
+//
+// The lock protocols are copies of the Readers-Writers programs with the console output
+// and sleeps removed; each program's upgrade() points back here, so a change to one is made
+// to both. resource_mutex is queue_locks::ExclusiveLock as in the programs, so building with
+// -DEXCLUSIVE_LOCK measures the same lock they run with. writer-first.cpp and
+// writer-first-collective-prefrence.cpp share the same lock code, so they are measured once.
+
+using Clock = std::chrono::steady_clock;
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+std::mutex cout_mutex;
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    std::cout << "\033[" << color << "m" << message << "\033[0m" << std::endl;
+}
+
+// Simulated work inside a critical section
+void work(int iterations) {
+    for (volatile int i = 0; i < iterations; i++) {
+    }
+}
+
+// reader-first.cpp: readers hold resource_mutex as a group
+class ReaderFirst {
+    queue_locks::ExclusiveLock resource_mutex;
+    std::mutex reader_count_mutex;
+    std::mutex upgrader_mutex;
+    std::condition_variable cv;
+    int reader_count = 0;
+    bool upgrade_pending = false;
+
+public:
+    void read_lock() {
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        cv.wait(lock, [this] { return !upgrade_pending; });
+        if (++reader_count == 1) resource_mutex.lock();
+    }
+
+    void read_unlock() {
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        if (--reader_count == 0) resource_mutex.unlock();
+        else if (reader_count == 1 && upgrade_pending) cv.notify_all();
+    }
+
+    void write_lock() { resource_mutex.lock(); }
+    void write_unlock() { resource_mutex.unlock(); }
+
+    void upgradable_lock() {
+        upgrader_mutex.lock();
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        if (++reader_count == 1) resource_mutex.lock();
+    }
+
+    void upgradable_unlock() {
+        read_unlock();
+        upgrader_mutex.unlock();
+    }
+
+    void upgrade() {
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        upgrade_pending = true;
+        cv.wait(lock, [this] { return reader_count == 1; });
+        reader_count--;
+    }
+
+    void upgraded_unlock() {
+        resource_mutex.unlock();
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            upgrade_pending = false;
+            cv.notify_all();
+        }
+        upgrader_mutex.unlock();
+    }
+};
+
+// writer-first.cpp / writer-first-collective-prefrence.cpp: readers back off while a writer waits
+class WriterFirst {
+    queue_locks::ExclusiveLock resource_mutex;
+    std::mutex reader_count_mutex;
+    std::mutex upgrader_mutex;
+    std::condition_variable cv;
+    int reader_count = 0;
+    bool writer_waiting = false;
+    bool upgrade_pending = false;
+
+public:
+    void read_lock() {
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        cv.wait(lock, [this] { return !writer_waiting && !upgrade_pending; });
+        if (++reader_count == 1) resource_mutex.lock();
+    }
+
+    void read_unlock() {
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        if (--reader_count == 0) resource_mutex.unlock();
+        else if (reader_count == 1 && upgrade_pending) cv.notify_all();
+    }
+
+    void write_lock() {
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            writer_waiting = true;
+        }
+        resource_mutex.lock();
+    }
+
+    void write_unlock() {
+        resource_mutex.unlock();
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        writer_waiting = false;
+        cv.notify_all();
+    }
+
+    void upgradable_lock() {
+        upgrader_mutex.lock();
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        cv.wait(lock, [this] { return !writer_waiting; });
+        if (++reader_count == 1) resource_mutex.lock();
+    }
+
+    void upgradable_unlock() {
+        read_unlock();
+        upgrader_mutex.unlock();
+    }
+
+    void upgrade() {
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        upgrade_pending = true;
+        cv.wait(lock, [this] { return reader_count == 1; });
+        reader_count--;
+    }
+
+    void upgraded_unlock() {
+        resource_mutex.unlock();
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            upgrade_pending = false;
+            cv.notify_all();
+        }
+        upgrader_mutex.unlock();
+    }
+};
+
+// reader-writer-fair.cpp: writer_active flag, each reader locks resource_mutex for itself,
+// and a read that ends with writers queued lets one of them go before new readers
+class Fair {
+    queue_locks::ExclusiveLock resource_mutex;
+    std::mutex reader_count_mutex;
+    std::mutex upgrader_mutex;
+    std::condition_variable cv;
+    int reader_count = 0;
+    bool writer_active = false;
+    bool upgrade_pending = false;
+    int writers_waiting = 0;
+    bool writer_turn = false;
+
+public:
+    void read_lock() {
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            cv.wait(lock, [this] { return !writer_active && !upgrade_pending && !writer_turn; });
+            reader_count++;
+        }
+        resource_mutex.lock();
+    }
+
+    void read_unlock() {
+        resource_mutex.unlock();
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        reader_count--;
+        writer_turn = writers_waiting > 0;
+        if (reader_count == 0 || (reader_count == 1 && upgrade_pending)) cv.notify_all();
+    }
+
+    void write_lock() {
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            writers_waiting++;
+            cv.wait(lock, [this] { return !writer_active && reader_count == 0; });
+            writers_waiting--;
+            writer_active = true;
+            writer_turn = false;
+        }
+        resource_mutex.lock();
+    }
+
+    void write_unlock() {
+        resource_mutex.unlock();
+        std::unique_lock<std::mutex> lock(reader_count_mutex);
+        writer_active = false;
+        cv.notify_all();
+    }
+
+    void upgradable_lock() {
+        upgrader_mutex.lock();
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            cv.wait(lock, [this] { return !writer_active && !writer_turn; });
+            reader_count++;
+        }
+        resource_mutex.lock();
+    }
+
+    void upgradable_unlock() {
+        resource_mutex.unlock();
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            reader_count--;
+            writer_turn = writers_waiting > 0;
+            if (reader_count == 0) cv.notify_all();
+        }
+        upgrader_mutex.unlock();
+    }
+
+    void upgrade() {
+        resource_mutex.unlock(); // Other counted readers may be queued on it
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            upgrade_pending = true;
+            cv.wait(lock, [this] { return reader_count == 1; });
+            reader_count--;
+            writer_active = true;
+            upgrade_pending = false;
+        }
+        resource_mutex.lock();
+    }
+
+    void upgraded_unlock() {
+        resource_mutex.unlock();
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            writer_active = false;
+            writer_turn = writers_waiting > 0;
+            cv.notify_all();
+        }
+        upgrader_mutex.unlock();
+    }
+};
+
+struct Result {
+    long long reads = 0;
+    long long updates = 0;
+    long long stale = 0;
+    double update_latency_us = 0;   // Mean time from starting the read to committing the write
+};
+
+enum Phase { WARMUP = 0, MEASURE = 1, DONE = 2 };
+
+// An updater decides to write three times out of four (xorshift, cheap and per thread)
+bool decide(unsigned& seed) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed % 4 != 0;
+}
+
+template <typename Lock>
+Result run(bool use_upgrade, int num_readers, int num_updaters, int work_iterations, std::chrono::milliseconds duration) {
+    const int think_iterations = 4 * work_iterations;   // Readers pause between reads, as in the programs
+    Lock lock;
+    int shared_memory = 0;
+    std::atomic<int> phase{WARMUP};
+    std::vector<long long> reads(num_readers, 0), updates(num_updaters, 0), stale(num_updaters, 0);
+    std::vector<double> latency(num_updaters, 0);
+    std::vector<std::thread> threads;
+
+    for (int r = 0; r < num_readers; r++) {
+        threads.emplace_back([&, r] {
+            long long count = 0;
+            int observed = 0;
+            while (phase != DONE) {
+                lock.read_lock();
+                observed = shared_memory;
+                work(work_iterations);
+                lock.read_unlock();
+                work(think_iterations);
+                if (phase == MEASURE) count++;
+            }
+            reads[r] = count;
+            (void)observed;
+        });
+    }
+
+    for (int u = 0; u < num_updaters; u++) {
+        threads.emplace_back([&, u] {
+            long long count = 0, stale_count = 0;
+            double total_us = 0;
+            unsigned seed = u + 1;
+            while (phase != DONE) {
+                auto start = Clock::now();
+                bool updated = false;
+
+                if (use_upgrade) {
+                    lock.upgradable_lock();
+                    int observed = shared_memory;
+                    work(work_iterations);
+                    if (decide(seed)) {
+                        lock.upgrade();
+                        shared_memory = observed + 1;
+                        work(work_iterations);
+                        lock.upgraded_unlock();
+                        updated = true;
+                    } else {
+                        lock.upgradable_unlock();
+                    }
+                } else {
+                    lock.read_lock();
+                    int observed = shared_memory;
+                    work(work_iterations);
+                    lock.read_unlock();
+                    if (decide(seed)) {
+                        lock.write_lock();
+                        if (shared_memory != observed) {
+                            stale_count += phase == MEASURE;   // The decision was made on an old value
+                        }
+                        shared_memory = shared_memory + 1;
+                        work(work_iterations);
+                        lock.write_unlock();
+                        updated = true;
+                    }
+                }
+
+                if (updated && phase == MEASURE) {
+                    count++;
+                    total_us += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+                }
+            }
+            updates[u] = count;
+            stale[u] = stale_count;
+            latency[u] = total_us;
+        });
+    }
+
+    std::this_thread::sleep_for(duration / 5);
+    auto start = Clock::now();
+    phase = MEASURE;
+    std::this_thread::sleep_for(duration);
+    phase = DONE;
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto& t : threads) t.join();
+
+    Result result;
+    double total_us = 0;
+    for (long long r : reads) result.reads += r;
+    for (int u = 0; u < num_updaters; u++) {
+        result.updates += updates[u];
+        result.stale += stale[u];
+        total_us += latency[u];
+    }
+    result.update_latency_us = result.updates ? total_us / result.updates : 0;
+    result.reads = (long long)(result.reads / seconds);
+    result.updates = (long long)(result.updates / seconds);
+    result.stale = (long long)(result.stale / seconds);
+    return result;
+}
+
+void print_row(const std::string& policy, const std::string& mode, const Result& r) {
+    std::ostringstream row;
+    row << std::left << std::setw(16) << policy << std::setw(10) << mode
+        << std::right << std::setw(12) << r.reads << std::setw(12) << r.updates
+        << std::setw(12) << r.stale << std::setw(16) << std::fixed << std::setprecision(1) << r.update_latency_us;
+    atomicPrint(row.str(), mode == "upgrade" ? GREEN : YELLOW);
+}
+
+template <typename Lock>
+void bench(const std::string& policy, int num_readers, int num_updaters, int work_iterations, std::chrono::milliseconds duration) {
+    print_row(policy, "requeue", run<Lock>(false, num_readers, num_updaters, work_iterations, duration));
+    print_row(policy, "upgrade", run<Lock>(true, num_readers, num_updaters, work_iterations, duration));
+}
+
+// Usage: upgradable [readers] [updaters] [work-iterations] [milliseconds-per-run]
+int main(int argc, char* argv[]) {
+    int num_readers = argc > 1 ? std::stoi(argv[1]) : 6;
+    int num_updaters = argc > 2 ? std::stoi(argv[2]) : 2;
+    int work_iterations = argc > 3 ? std::stoi(argv[3]) : 200;
+    std::chrono::milliseconds duration(argc > 4 ? std::stoi(argv[4]) : 1000);
+
+    std::ostringstream header;
+    header << std::left << std::setw(16) << "policy" << std::setw(10) << "mode"
+           << std::right << std::setw(12) << "reads/s" << std::setw(12) << "updates/s"
+           << std::setw(12) << "stale/s" << std::setw(16) << "update lat (us)";
+    atomicPrint(header.str(), CYAN);
+
+    bench<ReaderFirst>("reader-first", num_readers, num_updaters, work_iterations, duration);
+    bench<WriterFirst>("writer-first", num_readers, num_updaters, work_iterations, duration);
+    bench<Fair>("fair", num_readers, num_updaters, work_iterations, duration);
+
+    atomicPrint("Benchmark complete!", MAGENTA);
+    return 0;
+}
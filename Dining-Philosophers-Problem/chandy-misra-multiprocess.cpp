@@ -0,0 +1,259 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "../placement.h"
+#include "../cpu_accounting.h"
+#include "../shared_segment.h"
+
+// Chandy-Misra with every philosopher in its own process. The forks, with their mutex and
+// sync_channel, live in one mmap'ed MAP_SHARED segment:
+//   - each fork's mutex is a robust, process-shared pthread mutex
+//   - each fork's sync_channel is a shm::Channel, a non-private futex word
+//   - every philosopher holds a robust "alive" mutex, so its neighbours can tell it died
+//
+// The protocol is the one of chandy-misra.cpp, made safe for concurrent processes: a fork is
+// handed over only when it is dirty and not in use, and it arrives clean. A philosopher keeps
+// a clean fork until it has eaten with it, and both forks are dirty after a meal. Forks start
+// dirty, each with the lower-numbered of its two philosophers, so nobody can wait in a cycle.
+//
+// If a philosopher dies (killed mid-meal, or simply finished), its forks are treated as dirty
+// and free, so its neighbours carry on.
+//
+// CPU accounting: each philosopher counts its meals and wakeups into the segment, and the
+// parent reaps it with wait4(), which returns the child's CPU time and context switches.
+
+constexpr int MAX_PHILOSOPHERS = 64;
+
+struct SharedFork {
+    pthread_mutex_t mutex;      // Guards the fields below (robust, process-shared)
+    int owner;                  // Philosopher currently holding the fork
+    bool dirty;                 // Used since it was handed over: must be given up on request
+    bool in_use;                // The owner is eating with it
+    shm::Channel channel;       // Notified when the fork is put down
+};
+
+struct SharedTable {
+    int philosophers;
+    SharedFork forks[MAX_PHILOSOPHERS];
+    shm::Channel any_put_down;                      // Notified whenever any fork is put down
+
+    pthread_mutex_t reap_mutex;                     // Serializes death checks (robust)
+    shm::Liveness liveness[MAX_PHILOSOPHERS];
+    bool departed[MAX_PHILOSOPHERS];                // Guarded by reap_mutex
+
+    std::atomic<bool> eating[MAX_PHILOSOPHERS];     // Checked against the neighbours' flags
+    long long meals[MAX_PHILOSOPHERS];              // Written only by the philosopher itself
+    cpu_accounting::Counters counts[MAX_PHILOSOPHERS];
+    std::atomic<int> recovered;                     // Forks taken back from philosophers that died eating
+    std::atomic<long long> violations;              // Neighbours seen eating at the same time
+};
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    // One write() per line keeps lines from different processes from interleaving
+    std::string line = "\033[" + std::to_string(color) + "m" + message + "\033[0m\n";
+    ssize_t ignored = ::write(STDOUT_FILENO, line.data(), line.size());
+    (void)ignored;
+}
+
+bool is_dead(SharedTable* t, int philosopher) {
+    shm::lock_robust(&t->reap_mutex);   // A checker that died here left nothing half-done we rely on
+    if (t->liveness[philosopher].died()) t->departed[philosopher] = true;
+    bool dead = t->departed[philosopher];
+    pthread_mutex_unlock(&t->reap_mutex);
+    return dead;
+}
+
+void lock_fork(SharedFork* fork) {
+    // If the previous holder died in here, its half-done update only concerned its own
+    // ownership, and that is re-checked through is_dead() by the caller
+    shm::lock_robust(&fork->mutex);
+}
+
+void unlock_fork(SharedFork* fork) {
+    pthread_mutex_unlock(&fork->mutex);
+}
+
+// Must be called with the fork locked. Takes the fork if its owner must give it up.
+void try_take(SharedTable* t, SharedFork* fork, int philosopher) {
+    if (fork->owner == philosopher) return;
+    bool owner_dead = is_dead(t, fork->owner);
+    if (!owner_dead && (!fork->dirty || fork->in_use)) return;
+
+    if (owner_dead && fork->in_use) {
+        // The owner died mid-meal
+        t->eating[fork->owner] = false;
+        t->recovered++;
+    }
+    fork->owner = philosopher;
+    fork->dirty = false;   // A fork arrives clean
+    fork->in_use = false;
+}
+
+void pick_up(SharedTable* t, int philosopher, SharedFork* left, SharedFork* right) {
+    // Both fork mutexes are always taken in table order
+    SharedFork* first = left < right ? left : right;
+    SharedFork* second = left < right ? right : left;
+
+    for (bool woken = false;; woken = true) {
+        lock_fork(first);
+        lock_fork(second);
+        try_take(t, left, philosopher);
+        try_take(t, right, philosopher);
+
+        bool got_both = left->owner == philosopher && right->owner == philosopher;
+        if (woken) cpu_accounting::wakeup(got_both); // Woken or timed out while a fork is still missing
+        if (got_both) {
+            left->in_use = right->in_use = true;
+            unlock_fork(second);
+            unlock_fork(first);
+            return;
+        }
+
+        // Sleep until the fork we still miss is put down, or either of them when both are
+        // missing. The timeout catches a neighbour that died holding one.
+        bool missing_left = left->owner != philosopher;
+        bool missing_right = right->owner != philosopher;
+        shm::Channel* channel = missing_left && missing_right ? &t->any_put_down
+                              : missing_left ? &left->channel : &right->channel;
+        uint32_t seen = channel->snapshot();
+        unlock_fork(second);
+        unlock_fork(first);
+        channel->wait(seen, 100);
+    }
+}
+
+void put_down(SharedTable* t, SharedFork* left, SharedFork* right) {
+    SharedFork* first = left < right ? left : right;
+    SharedFork* second = left < right ? right : left;
+
+    lock_fork(first);
+    lock_fork(second);
+    left->in_use = right->in_use = false;
+    left->dirty = right->dirty = true;
+    unlock_fork(second);
+    unlock_fork(first);
+
+    left->channel.notify_all();
+    right->channel.notify_all();
+    t->any_put_down.notify_all();
+}
+
+void philosopher_process(SharedTable* t, int id, std::chrono::steady_clock::time_point end, bool crash) {
+    const int n = t->philosophers;
+    SharedFork* left = &t->forks[id];
+    SharedFork* right = &t->forks[(id + 1) % n];
+    int left_neighbor = (id + n - 1) % n;
+    int right_neighbor = (id + 1) % n;
+
+    t->liveness[id].register_self();
+    cpu_accounting::count_into(&t->counts[id]);
+
+    while (std::chrono::steady_clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50)); // Thinking
+
+        pick_up(t, id, left, right);
+        t->eating[id] = true;
+        if (t->eating[left_neighbor] || t->eating[right_neighbor]) t->violations++;
+        if (crash && t->meals[id] == 100) {
+            // Simulate a philosopher dying while it eats with both forks
+            kill(getpid(), SIGKILL);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50)); // Eating
+        t->meals[id]++;
+        t->eating[id] = false;
+        put_down(t, left, right);
+        cpu_accounting::work();
+    }
+}
+
+// Usage: chandy-misra-multiprocess [philosophers] [seconds] [crash]
+int main(int argc, char* argv[]) {
+    int philosophers = argc > 1 ? std::stoi(argv[1]) : 7;
+    int simulation_duration = argc > 2 ? std::stoi(argv[2]) : 5; // Simulation time in seconds
+    bool crash = argc > 3 && std::string(argv[3]) == "crash";
+
+    if (philosophers < 2 || philosophers > MAX_PHILOSOPHERS) {
+        atomicPrint("Between 2 and " + std::to_string(MAX_PHILOSOPHERS) + " philosophers are supported", RED);
+        return 1;
+    }
+
+    SharedTable* t = shm::create_segment<SharedTable>();
+    if (!t) {
+        atomicPrint(std::string("mmap failed: ") + std::strerror(errno), RED);
+        return 1;
+    }
+    t->philosophers = philosophers;
+    shm::init_robust_mutex(&t->reap_mutex);
+    for (int i = 0; i < philosophers; i++) {
+        SharedFork& fork = t->forks[i];
+        shm::init_robust_mutex(&fork.mutex);
+        fork.owner = i == 0 ? 0 : i - 1;   // Fork i lies between philosophers i - 1 and i
+        fork.dirty = true;
+        t->liveness[i].init();
+    }
+
+    atomicPrint(std::to_string(philosophers) + " philosopher processes for " + std::to_string(simulation_duration) + "s", YELLOW);
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(simulation_duration);
+    bool fork_failed = false;
+    std::map<pid_t, int> philosopher_of;   // Child pid -> philosopher, to match wait4()'s rusage
+    for (int i = 0; i < philosophers && !fork_failed; i++) {
+        pid_t pid = shm::spawn([&] {
+            placement::place_current(i, philosophers); // Pin according to PLACEMENT
+            philosopher_process(t, i, end, crash && i == 0);
+        });
+        fork_failed = pid == -1;
+        if (!fork_failed) philosopher_of[pid] = i;
+    }
+    if (fork_failed) {
+        atomicPrint(std::string("fork failed: ") + std::strerror(errno) + "; running with the philosophers started so far", RED);
+    }
+
+    // wait4() hands back each child's CPU time and context switches
+    std::vector<cpu_accounting::Usage> usage(philosophers);
+    std::vector<bool> reaped(philosophers, false);
+    int status;
+    rusage ru;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, 0, &ru)) > 0) {
+        int i = philosopher_of[pid];
+        usage[i] = cpu_accounting::usage_of(ru);
+        reaped[i] = true;
+    }
+
+    long long total = 0;
+    for (int i = 0; i < philosophers; i++) {
+        atomicPrint("Philosopher " + std::to_string(i + 1) + " ate " + std::to_string(t->meals[i]) + " times", GREEN);
+        total += t->meals[i];
+    }
+    atomicPrint("Meals: " + std::to_string(total) + " (" + std::to_string(total / simulation_duration) + " meals/s)", CYAN);
+    atomicPrint("Forks recovered from dead philosophers: " + std::to_string(t->recovered)
+                + " | Neighbours eating together: " + std::to_string(t->violations), CYAN);
+
+    cpu_accounting::Ledger ledger;
+    for (int i = 0; i < philosophers; i++) {
+        if (reaped[i]) ledger.record("Philosopher " + std::to_string(i + 1), usage[i], t->counts[i]);
+    }
+    for (const std::string& line : ledger.report("chandy-misra (processes)", "meal")) {
+        atomicPrint(line, CYAN);
+    }
+    atomicPrint("Simulation complete!", YELLOW);
+
+    shm::destroy_segment(t);
+    return fork_failed ? 1 : 0;
+}
@@ -8,6 +8,11 @@
 #include <iomanip>
 #include <condition_variable>
 
+#include "../layout.h"
+#include "../placement.h"
+#include "../queue_locks.h"
+#include "../cpu_accounting.h"
+
 enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
 
 std::mutex coutMutex;  // Add this at the global scope
@@ -25,9 +30,12 @@ class sync_channel{
     std::condition_variable cv;
 
 public:
-    void wait(){
+    // ready() is checked under the channel mutex, which notifyall() takes too, so a
+    // notification sent after the waiter's state changed is never missed
+    template <typename Predicate>
+    void wait(Predicate ready){
         std::unique_lock<std::mutex> lock(mutex);
-        cv.wait(lock);
+        cv.wait(lock, ready);
     }
 
     void notifyall(){
@@ -37,29 +45,41 @@ public:
 };
 
 struct table_setup{
+   std::atomic<bool> started{ false };
    std::atomic<bool> done{ false };
    sync_channel channel;
 };
 
+// Owner, dirty flag, mutex (picked by EXCLUSIVE_LOCK, queue_locks.h) and channel of every
+// fork, in the layout picked by -DLAYOUT (layout.h)
+using fork_table = layout::ForkTable<LAYOUT, queue_locks::ExclusiveLock, sync_channel>;
+
+// A fork is its id plus its row of the fork table
 class fork{
    int id;
-   int owner;
-   bool dirty;
-   std::mutex mutex;
-   sync_channel channel;
+   int& owner;
+   bool& dirty;
+   queue_locks::ExclusiveLock& mutex;
+   sync_channel& channel;
 
 public:
-    fork(int const forkId, int const ownerId): id(forkId), owner(ownerId), dirty(true){}
+    fork(fork_table & forks, int const forkId, int const ownerId):
+        id(forkId), owner(forks.owner(forkId - 1)), dirty(forks.dirty(forkId - 1)),
+        mutex(forks.mutex(forkId - 1)), channel(forks.channel(forkId - 1)){
+        owner = ownerId;
+        dirty = true;
+    }
 
     int getId() const { return id; }  // Add this getter
 
-    void request(int const ownerId)
+    // Returns false if dinner ended before the fork could be taken
+    bool request(int const ownerId, std::atomic<bool> const & done)
     {
         while (owner != ownerId)
         {
             if (dirty)
             {
-                std::lock_guard<std::mutex> lock(mutex);
+                std::lock_guard<queue_locks::ExclusiveLock> lock(mutex);
                 dirty = false;
                 owner = ownerId;
                 
@@ -70,11 +90,16 @@ public:
             }
             else
             {
-                channel.wait();
+                channel.wait(cpu_accounting::counted([&] { return dirty || done; }));
+                if (!dirty) return false;
             }
         }
+        return true;
     }
 
+    // Wakes a philosopher waiting for this fork, so it notices that dinner is over
+    void wake() { channel.notifyall(); }
+
     void done_using()
     {
         // Print when fork is put down
@@ -85,7 +110,7 @@ public:
         dirty = true;
         channel.notifyall();
     }
-    std::mutex& getmutex() { return mutex; }
+    queue_locks::ExclusiveLock& getmutex() { return mutex; }
 };
 
 struct philosopher {
@@ -105,7 +130,8 @@ public:
     }
 
     void dine(){
-        setup.channel.wait();
+        cpu_accounting::Scope account("Philosopher " + name);
+        setup.channel.wait([this] { return setup.started.load(); }); // A philosopher may get here after start()
 
         do{
          think();
@@ -135,13 +161,23 @@ public:
     {
         atomicPrint(name + " attempting to pick up forks...", YELLOW);
         
-        left_fork.request(id);
-        right_fork.request(id);
-
+        if (!left_fork.request(id, setup.done) || !right_fork.request(id, setup.done)) return;
+
+#if EXCLUSIVE_LOCK == LOCK_CLH
+        // CLH has no try_lock for std::lock; taking the lower-numbered fork first is deadlock-free too
+        if (left_fork.getId() < right_fork.getId()) {
+            left_fork.getmutex().lock();
+            right_fork.getmutex().lock();
+        } else {
+            right_fork.getmutex().lock();
+            left_fork.getmutex().lock();
+        }
+#else
         std::lock(left_fork.getmutex(), right_fork.getmutex());
+#endif
 
-        std::lock_guard<std::mutex> left_lock(left_fork.getmutex(), std::adopt_lock);
-        std::lock_guard<std::mutex> right_lock(right_fork.getmutex(), std::adopt_lock);
+        std::lock_guard<queue_locks::ExclusiveLock> left_lock(left_fork.getmutex(), std::adopt_lock);
+        std::lock_guard<queue_locks::ExclusiveLock> right_lock(right_fork.getmutex(), std::adopt_lock);
 
         std::string eating_msg = name + " started eating with forks " + 
                                 std::to_string(left_fork.getId()) + " and " + 
@@ -151,6 +187,7 @@ public:
         std::this_thread::sleep_for(std::chrono::seconds(1));
         
         atomicPrint(name + " finished eating.", YELLOW);
+        cpu_accounting::work();
 
         left_fork.done_using();
         right_fork.done_using();
@@ -164,17 +201,18 @@ public:
 class table {
 public: 
     table_setup setup;
+    fork_table fork_state{no_of_philosophers};
 
     std::array<fork, no_of_philosophers> forks
     {
         {
-            { 1, 1 },
-            { 2, 2 },
-            { 3, 3 },
-            { 4, 4 },
-            { 5, 5 },
-            { 6, 6 },
-            { 7, 1 },
+            { fork_state, 1, 1 },
+            { fork_state, 2, 2 },
+            { fork_state, 3, 3 },
+            { fork_state, 4, 4 },
+            { fork_state, 5, 5 },
+            { fork_state, 6, 6 },
+            { fork_state, 7, 1 },
         }
     };
 
@@ -191,24 +229,38 @@ public:
         }
     };
 
+    table(){
+        // Pin philosophers according to PLACEMENT (neighbours share a fork)
+        for (int i = 0; i < no_of_philosophers; i++){
+            placement::place(philosophers[i].lifethread, i, no_of_philosophers);
+        }
+    }
+
     void start(){
+        setup.started = true;
         setup.channel.notifyall();
     }
 
     void stop(){
         setup.done = true;
+        for (auto& f : forks) f.wake();
     }
 };
 
 void dine(){
-    atomicPrint("Dinner started!", MAGENTA);
+    atomicPrint(std::string("Dinner started! (") + layout::name(LAYOUT) + " layout, " + queue_locks::exclusive_lock_name + " forks)", MAGENTA);
 
     {
         table table;
 
         table.start();
         std::this_thread::sleep_for(std::chrono::seconds(60));
+
         table.stop();
+    } // Philosophers leave the table and are joined here
+
+    for (std::string const & line : cpu_accounting::ledger().report("chandy-misra", "meal")) {
+        atomicPrint(line, CYAN);
     }
 
     atomicPrint("Dinner done!", MAGENTA);
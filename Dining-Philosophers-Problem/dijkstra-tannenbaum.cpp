@@ -7,6 +7,11 @@
 #include <string>
 #include <atomic>
 
+#include "../layout.h"
+#include "../placement.h"
+#include "../queue_locks.h"
+#include "../cpu_accounting.h"
+
 using namespace std;
 
 const int N = 5;
@@ -14,12 +19,17 @@ const int THINKING = 2;
 const int HUNGRY = 1;
 const int EATING = 0;
 
-vector<int> state(N, THINKING);
+// State and condition variable of every philosopher, in the layout picked by -DLAYOUT
+// (layout.h): split keeps the states test() scans packed and gives every cv its own line
+layout::PhilosopherTable<LAYOUT, queue_locks::ExclusiveCondition> table(N, THINKING);
+
+int& state_of(int phnum) { return table.state(phnum); }
+queue_locks::ExclusiveCondition& cv_of(int phnum) { return table.cv(phnum); }
+
 vector<int> philosophers = {0, 1, 2, 3, 4};
 
-mutex mtx;
+CACHE_ALIGNED queue_locks::ExclusiveLock mtx; // Exclusive lock picked by EXCLUSIVE_LOCK (queue_locks.h)
 mutex coutMutex; // Mutex for synchronized console output
-condition_variable cv[N];
 atomic<bool> should_terminate(false); // Flag to signal threads to terminate
 
 #define LEFT(phnum) ((phnum + N - 1) % N)
@@ -34,34 +44,35 @@ void atomicPrint(const std::string& message, Color color = WHITE) {
 }
 
 void test(int phnum) {
-    if (state[phnum] == HUNGRY && state[LEFT(phnum)] != EATING && state[RIGHT(phnum)] != EATING) {
-        state[phnum] = EATING;
+    if (state_of(phnum) == HUNGRY && state_of(LEFT(phnum)) != EATING && state_of(RIGHT(phnum)) != EATING) {
+        state_of(phnum) = EATING;
 
         atomicPrint("Philosopher " + to_string(phnum + 1) + " takes fork " +
                     to_string(LEFT(phnum) + 1) + " and " + to_string(phnum + 1), GREEN);
         atomicPrint("Philosopher " + to_string(phnum + 1) + " is Eating", BLUE);
 
-        cv[phnum].notify_one();
+        cv_of(phnum).notify_one();
     }
 }
 
 void take_fork(int phnum) {
-    unique_lock<mutex> lock(mtx);
+    unique_lock<queue_locks::ExclusiveLock> lock(mtx);
 
-    state[phnum] = HUNGRY;
+    state_of(phnum) = HUNGRY;
     atomicPrint("Philosopher " + to_string(phnum + 1) + " is Hungry", RED);
 
     test(phnum);
 
-    while (state[phnum] != EATING && !should_terminate) {
-        cv[phnum].wait_for(lock, chrono::milliseconds(100));
+    while (state_of(phnum) != EATING && !should_terminate) {
+        cv_of(phnum).wait_for(lock, chrono::milliseconds(100));
+        cpu_accounting::wakeup(state_of(phnum) == EATING); // Timeouts that find the forks still taken are wasted
     }
 }
 
 void put_fork(int phnum) {
-    unique_lock<mutex> lock(mtx);
+    unique_lock<queue_locks::ExclusiveLock> lock(mtx);
 
-    state[phnum] = THINKING;
+    state_of(phnum) = THINKING;
     atomicPrint("Philosopher " + to_string(phnum + 1) + " putting fork " +
                 to_string(LEFT(phnum) + 1) + " and " + to_string(phnum + 1) + " down", MAGENTA);
     atomicPrint("Philosopher " + to_string(phnum + 1) + " is thinking", YELLOW);
@@ -71,12 +82,14 @@ void put_fork(int phnum) {
 }
 
 void philosopher(int phnum) {
+    cpu_accounting::Scope account("Philosopher " + to_string(phnum + 1));
     while (!should_terminate) {
         this_thread::sleep_for(chrono::seconds(1));
         take_fork(phnum);
         if (!should_terminate) {
             this_thread::sleep_for(chrono::seconds(1));
             put_fork(phnum);
+            cpu_accounting::work();
         }
     }
 }
@@ -88,6 +101,7 @@ int main() {
     // Start threads
     for (int i = 0; i < N; ++i) {
         threads[i] = thread(philosopher, i);
+        placement::place(threads[i], i, N); // Pin according to PLACEMENT
     }
 
     // Sleep for simulation duration
@@ -103,6 +117,10 @@ int main() {
         }
     }
 
+    for (const string& line : cpu_accounting::ledger().report("dijkstra-tannenbaum", "meal")) {
+        atomicPrint(line, CYAN);
+    }
+
     atomicPrint("Simulation complete!", RED);
 
     return 0;
@@ -1,36 +1,154 @@
 #include <iostream>
-#include <queue>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
 #include <vector>
 #include <random>
+#include <string>
+#include <algorithm>
+#include <atomic>
+
+#include "../layout.h"
+#include "../placement.h"
+#include "../cpu_accounting.h"
 
 using namespace std;
 
+// Grant handed to one philosopher. dispatch() sets it under the owner's own mutex, so a
+// woken philosopher never takes the table mutex just to learn that it may eat.
+struct Wakeup {
+    mutex m;
+    condition_variable cv;
+    bool granted = false;
+};
+
+// Per-philosopher tables in the layout picked by -DLAYOUT (layout.h). Packed keeps the
+// chopstick flags bit-packed and the wakeups back to back, so neighbours share lines. Split
+// keeps the flags dispatch() scans as plain bytes packed together, and gives every wakeup
+// (touched by its owner outside the table mutex) its own line, as padded does.
+using FlagArray = layout::FlagArray<LAYOUT>;
+using WakeupCell = layout::Cell<LAYOUT, Wakeup>;
+
+// Indexed binary min-heap over philosopher ids.
+// position[] maps an id to its slot in the heap, so any waiter can be removed in O(log n)
+// instead of the linear scan a std::queue / std::priority_queue would need. There is no
+// in-place key change: with at most one waiter per philosopher, aging simply erases and
+// pushes them back with their new key.
+class IndexedMinHeap {
+private:
+    vector<int> heap;              // philosopher ids, heap-ordered by (key, order)
+    vector<int> position;          // position[id] = index in heap, -1 if not queued
+    vector<long long> key;         // scheduling key (arrival sequence or deadline)
+    vector<long long> order;       // arrival sequence, breaks ties between equal keys
+
+    bool less(int a, int b) const {
+        int idA = heap[a], idB = heap[b];
+        if (key[idA] != key[idB]) return key[idA] < key[idB];
+        return order[idA] < order[idB];
+    }
+
+    void swapNodes(int a, int b) {
+        swap(heap[a], heap[b]);
+        position[heap[a]] = a;
+        position[heap[b]] = b;
+    }
+
+    void siftUp(int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(i, parent)) break;
+            swapNodes(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(int i) {
+        int n = heap.size();
+        while (true) {
+            int smallest = i;
+            int left = 2 * i + 1, right = 2 * i + 2;
+            if (left < n && less(left, smallest)) smallest = left;
+            if (right < n && less(right, smallest)) smallest = right;
+            if (smallest == i) break;
+            swapNodes(i, smallest);
+            i = smallest;
+        }
+    }
+
+public:
+    explicit IndexedMinHeap(int capacity) : position(capacity, -1), key(capacity, 0), order(capacity, 0) {}
+
+    bool empty() const { return heap.empty(); }
+    int top() const { return heap.front(); }
+    long long keyOf(int id) const { return key[id]; }
+    long long orderOf(int id) const { return order[id]; }
+
+    void push(int id, long long k, long long seq) {
+        key[id] = k;
+        order[id] = seq;
+        heap.push_back(id);
+        position[id] = heap.size() - 1;
+        siftUp(position[id]);
+    }
+
+    void pop() {
+        erase(heap.front());
+    }
+
+    void erase(int id) {
+        int i = position[id];
+        int last = heap.size() - 1;
+        if (i != last) swapNodes(i, last);
+        heap.pop_back();
+        position[id] = -1;
+        if (i < (int)heap.size()) {
+            siftDown(i);
+            siftUp(i);
+        }
+    }
+};
+
 class DiningPhilosophers {
+public:
+    enum class Schedule { FIFO, EDF };
+
 private:
-    struct ChopstickPair {
-        int first, second;
-        ChopstickPair(int f, int s) : first(f), second(s) {}
-    };
+    // Latency-sensitive requesters have a tight deadline, batch requesters a loose one
+    enum PriorityClass { LATENCY = 0, BATCH = 1, NUM_CLASSES = 2 };
 
     const int numPhilosophers = 7;
-    vector<bool> chopsticks;
-    queue<int> waitingPhilosophers;
-    mutex mtx;
-    condition_variable cv;
+    const Schedule schedule;
+    const bool overload;
+
+    // Relative deadlines per class. Aging promotes a waiter by agingPercent of the time it has
+    // waited, and never by more than maxPromotion, so a batch request can at most become as
+    // urgent as a latency request made at the same time.
+    const chrono::milliseconds classDeadline[NUM_CLASSES] = {chrono::milliseconds(2000), chrono::milliseconds(10000)};
+    const int agingPercent = 20;
+    const chrono::milliseconds maxPromotion = classDeadline[BATCH] - classDeadline[LATENCY];
+
+    FlagArray chopsticks;
+    IndexedMinHeap waitingPhilosophers;
+    vector<chrono::steady_clock::time_point> requestTime;
+    vector<chrono::steady_clock::time_point> deadline;
+    long long arrivalSequence = 0;
+    CACHE_ALIGNED mutex mtx;             // Guards the chopsticks and the waiting queue
+    vector<WakeupCell> wakeups;          // one per philosopher, so a grant wakes only its owner
     vector<thread> threads;
-    bool running = true;
+    atomic<bool> running{true};
+    const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+    // Wait time (request -> grant) samples and deadline misses per class
+    vector<long long> waitSamples[NUM_CLASSES];
+    int deadlineMisses[NUM_CLASSES] = {0, 0};
 
     // Mutex for atomic console output
     mutex coutMutex;
 
-    // Random number generator for eating time
-    random_device rd;
-    mt19937 gen{rd()};
-    uniform_int_distribution<> eatTime{1000, 3000};
+    // Ranges for eating time and overloaded thinking time; each thread draws with its own generator
+    const uniform_int_distribution<> eatTime{1000, 3000};
+    const uniform_int_distribution<> overloadThinkTime{0, 100};
 
     // Thread-safe function for printing with color
     enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
@@ -40,11 +158,146 @@ private:
         cout << "\033[" << color << "m" << message << "\033[0m" << endl;
     }
 
+    // Even philosophers are latency-sensitive, odd ones are batch jobs
+    PriorityClass classOf(int philosopherId) const {
+        return philosopherId % 2 == 0 ? LATENCY : BATCH;
+    }
+
+    const char* className(int c) const {
+        return c == LATENCY ? "latency" : "batch";
+    }
+
+    long long sinceEpoch(chrono::steady_clock::time_point t) const {
+        return chrono::duration_cast<chrono::milliseconds>(t - epoch).count();
+    }
+
+    // Must be called with mtx held.
+    // EDF key: the deadline, moved earlier in proportion to the time already spent waiting
+    long long agedKey(int philosopherId, chrono::steady_clock::time_point now) const {
+        auto waited = chrono::duration_cast<chrono::milliseconds>(now - requestTime[philosopherId]);
+        auto promotion = min(waited * agingPercent / 100, maxPromotion);
+        return sinceEpoch(deadline[philosopherId] - promotion);
+    }
+
+    // Must be called with mtx held
+    void enqueue(int philosopherId) {
+        auto now = chrono::steady_clock::now();
+        requestTime[philosopherId] = now;
+        deadline[philosopherId] = now + classDeadline[classOf(philosopherId)];
+
+        long long seq = arrivalSequence++;
+        long long key = schedule == Schedule::FIFO ? seq : sinceEpoch(deadline[philosopherId]);
+        waitingPhilosophers.push(philosopherId, key, seq);
+    }
+
+    // Must be called with mtx held.
+    // Grants chopsticks to waiters in key order. Both chopsticks are taken atomically under mtx,
+    // so nobody ever holds one while waiting for the other and no deadlock is possible.
+    // FIFO stops at the first blocked waiter (strict head-of-line, as before). EDF lets later
+    // waiters through, but reserves the chopsticks of every blocked waiter ahead of them so an
+    // urgent request is never overtaken on the chopsticks it needs. EDF keys are re-aged from
+    // the elapsed wait on every pass, so promotion tracks time, not how often dispatch() runs.
+    void dispatch() {
+        vector<bool> reserved(numPhilosophers, false);
+        vector<int> blocked;
+
+        if (schedule == Schedule::EDF) {
+            auto now = chrono::steady_clock::now();
+            vector<int> waiting;
+            while (!waitingPhilosophers.empty()) {
+                waiting.push_back(waitingPhilosophers.top());
+                waitingPhilosophers.pop();
+            }
+            for (int id : waiting) {
+                waitingPhilosophers.push(id, agedKey(id, now), waitingPhilosophers.orderOf(id));
+            }
+        }
+
+        while (!waitingPhilosophers.empty()) {
+            int id = waitingPhilosophers.top();
+            int leftChopstick = id;
+            int rightChopstick = (id + 1) % numPhilosophers;
+
+            if (canTakeChopsticks(id) && !reserved[leftChopstick] && !reserved[rightChopstick]) {
+                waitingPhilosophers.pop();
+                takeChopsticks(id);
+                recordGrant(id);
+                atomicPrint("Philosopher " + to_string(id) + " takes chopsticks "
+                            + to_string(leftChopstick) + " and "
+                            + to_string(rightChopstick), GREEN);
+                grant(id);
+                continue;
+            }
+
+            if (schedule == Schedule::FIFO) break;
+
+            reserved[leftChopstick] = true;
+            reserved[rightChopstick] = true;
+            blocked.push_back(id);
+            waitingPhilosophers.pop();
+        }
+
+        // Blocked waiters go back with the keys they were just ordered by
+        for (int id : blocked) {
+            waitingPhilosophers.push(id, waitingPhilosophers.keyOf(id), waitingPhilosophers.orderOf(id));
+        }
+    }
+
+    // Must be called with mtx held
+    void grant(int philosopherId) {
+        Wakeup& w = wakeups[philosopherId].value;
+        {
+            lock_guard<mutex> lock(w.m);
+            w.granted = true;
+        }
+        w.cv.notify_one();
+    }
+
+    // Must be called with mtx held
+    void recordGrant(int philosopherId) {
+        auto now = chrono::steady_clock::now();
+        int c = classOf(philosopherId);
+        waitSamples[c].push_back(chrono::duration_cast<chrono::milliseconds>(now - requestTime[philosopherId]).count());
+        if (now > requestTime[philosopherId] + classDeadline[c]) {
+            deadlineMisses[c]++;
+        }
+    }
+
+    static long long percentile(vector<long long>& samples, double p) {
+        if (samples.empty()) return 0;
+        size_t index = min(samples.size() - 1, (size_t)(p * samples.size()));
+        nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+
+    void report() {
+        atomicPrint(string("Schedule: ") + (schedule == Schedule::FIFO ? "fifo" : "edf")
+                    + (overload ? " (overload)" : "") + ", " + layout::name(LAYOUT) + " layout", CYAN);
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            vector<long long>& samples = waitSamples[c];
+            int count = samples.size();
+            long long p50 = percentile(samples, 0.50);
+            long long p95 = percentile(samples, 0.95);
+            long long p99 = percentile(samples, 0.99);
+            atomicPrint(string(className(c)) + ": grants=" + to_string(count)
+                        + " wait p50=" + to_string(p50) + "ms"
+                        + " p95=" + to_string(p95) + "ms"
+                        + " p99=" + to_string(p99) + "ms"
+                        + " deadline misses=" + to_string(deadlineMisses[c]), CYAN);
+        }
+        for (const string& line : cpu_accounting::ledger().report(string("queue ") + (schedule == Schedule::FIFO ? "fifo" : "edf"), "meal")) {
+            atomicPrint(line, CYAN);
+        }
+    }
+
 public:
-    DiningPhilosophers() : chopsticks(numPhilosophers, true) {
+    DiningPhilosophers(Schedule s = Schedule::FIFO, bool overloaded = false)
+        : schedule(s), overload(overloaded), chopsticks(numPhilosophers, true),
+          waitingPhilosophers(numPhilosophers), requestTime(numPhilosophers), deadline(numPhilosophers),
+          wakeups(numPhilosophers) {
         // Initially all philosophers are waiting
         for (int i = 0; i < numPhilosophers; i++) {
-            waitingPhilosophers.push(i);
+            enqueue(i);
         }
     }
 
@@ -69,43 +322,46 @@ public:
     }
 
     void philosopherBehavior(int id) {
+        cpu_accounting::Scope account("Philosopher " + to_string(id));
+        mt19937 gen{random_device{}()};
+        uniform_int_distribution<> eatTime = this->eatTime;
+        uniform_int_distribution<> overloadThinkTime = this->overloadThinkTime;
         while (running) {
             {
-                unique_lock<mutex> lock(mtx);
-                
-                // Wait until it's this philosopher's turn and they can take chopsticks
-                while (waitingPhilosophers.front() != id || !canTakeChopsticks(id)) {
-                    cv.wait(lock);
-                    if (!running) return;
-                }
-
-                // Take chopsticks and remove philosopher from waiting queue
-                atomicPrint("Philosopher " + to_string(id) + " takes chopsticks " 
-                            + to_string(id) + " and " 
-                            + to_string((id + 1) % numPhilosophers), GREEN);
-                takeChopsticks(id);
-                waitingPhilosophers.pop();
+                Wakeup& w = wakeups[id].value;
+                unique_lock<mutex> lock(w.m);
+
+                // Wait until the dispatcher has handed this philosopher both chopsticks
+                w.cv.wait(lock, cpu_accounting::counted([&] { return w.granted || !running; }));
+                if (!running) return;
+                w.granted = false;
             }
 
             // Eating
             atomicPrint("Philosopher " + to_string(id) + " is eating", BLUE);
             this_thread::sleep_for(chrono::milliseconds(eatTime(gen)));
+            cpu_accounting::work();
 
             {
                 unique_lock<mutex> lock(mtx);
-                
-                // Return chopsticks and go back to waiting queue
+
+                // Return chopsticks and hand them to whoever is next
                 atomicPrint("Philosopher " + to_string(id) + " returns chopsticks", YELLOW);
                 returnChopsticks(id);
-                waitingPhilosophers.push(id);
-                
-                // Notify other philosophers that chopsticks are available
-                cv.notify_all();
+                dispatch();
             }
 
             // Thinking
             atomicPrint("Philosopher " + to_string(id) + " is thinking", MAGENTA);
-            this_thread::sleep_for(chrono::milliseconds(eatTime(gen)));
+            this_thread::sleep_for(chrono::milliseconds(overload ? overloadThinkTime(gen) : eatTime(gen)));
+
+            {
+                unique_lock<mutex> lock(mtx);
+
+                // Hungry again: go back to the waiting queue
+                enqueue(id);
+                dispatch();
+            }
         }
     }
 
@@ -113,7 +369,11 @@ public:
         // Create threads for all philosophers
         for (int i = 0; i < numPhilosophers; i++) {
             threads.emplace_back(&DiningPhilosophers::philosopherBehavior, this, i);
+            placement::place(threads.back(), i, numPhilosophers); // Pin according to PLACEMENT
         }
+
+        unique_lock<mutex> lock(mtx);
+        dispatch();
     }
 
     void stop() {
@@ -121,20 +381,34 @@ public:
             unique_lock<mutex> lock(mtx);
             running = false;
         }
-        cv.notify_all();
+        for (auto& c : wakeups) {
+            lock_guard<mutex> lock(c.value.m); // A philosopher between its check and its wait still sees running
+            c.value.cv.notify_all();
+        }
         for (auto& thread : threads) {
             thread.join();
         }
+        report();
     }
 };
 
-int main() {
-    DiningPhilosophers dp;
+// Usage: queue [fifo|edf] [overload]
+int main(int argc, char* argv[]) {
+    DiningPhilosophers::Schedule schedule = DiningPhilosophers::Schedule::FIFO;
+    bool overload = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "edf") schedule = DiningPhilosophers::Schedule::EDF;
+        else if (arg == "fifo") schedule = DiningPhilosophers::Schedule::FIFO;
+        else if (arg == "overload") overload = true;
+    }
+
+    DiningPhilosophers dp(schedule, overload);
     dp.start();
 
     // Let the simulation run for 30 seconds
     this_thread::sleep_for(chrono::seconds(30));
-    
+
     dp.stop();
     cout << "\033[32mSimulation complete!\033[0m" << endl;
     return 0;
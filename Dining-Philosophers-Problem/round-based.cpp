@@ -0,0 +1,430 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+// Round-based dining philosophers.
+//
+// The other engines grant philosophers one at a time, in reaction to a single release.
+// This engine works in rounds: it collects everything that happened since the last round
+// (releases, new hungry philosophers, arrivals and departures) and then grants a maximal
+// independent set of hungry philosophers over the conflict graph in one go.
+//
+// The independent set is kept incrementally: eatingNeighbors[v] counts the neighbors of v
+// that are eating, and v is a candidate as soon as it is hungry and that count is zero.
+// Each event touches only v and its neighbors, so a round costs O(grants * degree log n)
+// rather than a scan of the whole table.
+//
+// Thousands of philosopher threads are not practical, so all engines run in the same
+// discrete-time simulation (1 tick = 1 ms) and are compared on meals per simulated second
+// and chopstick utilization.
+
+enum State { AWAY, THINKING, HUNGRY, EATING };
+
+// Conflict graph: philosophers that share a chopstick are neighbors
+struct ConflictGraph {
+    vector<vector<int>> neighbors;
+    int chopsticks = 0;
+
+    // Every philosopher eats with two chopsticks; uses[i] names philosopher i's pair
+    static ConflictGraph fromChopsticks(const vector<pair<int, int>>& uses, int chopsticks) {
+        vector<vector<int>> users(chopsticks);
+        for (int i = 0; i < (int)uses.size(); i++) {
+            users[uses[i].first].push_back(i);
+            users[uses[i].second].push_back(i);
+        }
+
+        ConflictGraph g;
+        g.neighbors.resize(uses.size());
+        g.chopsticks = chopsticks;
+        for (const vector<int>& sharing : users) {
+            for (int a : sharing) {
+                for (int b : sharing) {
+                    if (a != b) g.neighbors[a].push_back(b);
+                }
+            }
+        }
+        for (vector<int>& list : g.neighbors) {
+            sort(list.begin(), list.end());
+            list.erase(unique(list.begin(), list.end()), list.end());
+        }
+        return g;
+    }
+
+    // The classic table: philosopher i shares chopstick i with i + 1
+    static ConflictGraph ring(int n) {
+        vector<pair<int, int>> uses(n);
+        for (int i = 0; i < n; i++) {
+            uses[i] = {(i + n - 1) % n, i};
+        }
+        return fromChopsticks(uses, n);
+    }
+
+    // n philosophers each picking two distinct chopsticks out of n at random, so some
+    // chopsticks are contended by three or more philosophers and others by none
+    static ConflictGraph random(int n, unsigned seed) {
+        mt19937 gen(seed);
+        uniform_int_distribution<> pick{0, n - 1};
+        vector<pair<int, int>> uses(n);
+        for (auto& [first, second] : uses) {
+            first = pick(gen);
+            do {
+                second = pick(gen);
+            } while (second == first);
+        }
+        return fromChopsticks(uses, n);
+    }
+
+    int size() const { return neighbors.size(); }
+};
+
+// Common interface for the engines under test
+class Engine {
+public:
+    virtual ~Engine() = default;
+    virtual string name() const = 0;
+    virtual void hungry(int philosopherId, long long tick) = 0;
+    virtual void release(int philosopherId) = 0;
+    // May be called in any state, including while the philosopher eats
+    virtual void leave(int philosopherId) = 0;
+    // Called once per tick after all events; returns who may eat now
+    virtual void round(vector<int>& granted) = 0;
+};
+
+class RoundEngine : public Engine {
+private:
+    const ConflictGraph& graph;
+    vector<State> state;
+    vector<int> eatingNeighbors;
+    vector<long long> hungrySince;
+    // Candidates ordered oldest-hungry first; stale entries are skipped when popped
+    priority_queue<pair<long long, int>, vector<pair<long long, int>>, greater<pair<long long, int>>> candidates;
+
+    void offer(int philosopherId) {
+        if (state[philosopherId] == HUNGRY && eatingNeighbors[philosopherId] == 0) {
+            candidates.push({hungrySince[philosopherId], philosopherId});
+        }
+    }
+
+public:
+    explicit RoundEngine(const ConflictGraph& g)
+        : graph(g), state(g.size(), THINKING), eatingNeighbors(g.size(), 0), hungrySince(g.size(), 0) {}
+
+    string name() const override { return "round"; }
+
+    void hungry(int philosopherId, long long tick) override {
+        state[philosopherId] = HUNGRY;
+        hungrySince[philosopherId] = tick;
+        offer(philosopherId);
+    }
+
+    void release(int philosopherId) override {
+        state[philosopherId] = THINKING;
+        for (int neighbor : graph.neighbors[philosopherId]) {
+            eatingNeighbors[neighbor]--;
+            offer(neighbor);
+        }
+    }
+
+    void leave(int philosopherId) override {
+        // Put the chopsticks down first so the neighbors' counts stay right; a queued
+        // candidate entry for a hungry philosopher is skipped once it is AWAY
+        if (state[philosopherId] == EATING) release(philosopherId);
+        state[philosopherId] = AWAY;
+    }
+
+    void round(vector<int>& granted) override {
+        while (!candidates.empty()) {
+            auto [since, id] = candidates.top();
+            candidates.pop();
+            if (state[id] != HUNGRY || eatingNeighbors[id] != 0 || since != hungrySince[id]) continue;
+
+            state[id] = EATING;
+            for (int neighbor : graph.neighbors[id]) {
+                eatingNeighbors[neighbor]++;
+            }
+            granted.push_back(id);
+        }
+    }
+};
+
+// dijkstra-tannenbaum.cpp: test() on becoming hungry and on each neighbor's release
+class DijkstraEngine : public Engine {
+private:
+    const ConflictGraph& graph;
+    vector<State> state;
+    vector<int> pending;
+
+    void test(int philosopherId) {
+        if (state[philosopherId] != HUNGRY) return;
+        for (int neighbor : graph.neighbors[philosopherId]) {
+            if (state[neighbor] == EATING) return;
+        }
+        state[philosopherId] = EATING;
+        pending.push_back(philosopherId);
+    }
+
+public:
+    explicit DijkstraEngine(const ConflictGraph& g) : graph(g), state(g.size(), THINKING) {}
+
+    string name() const override { return "dijkstra"; }
+
+    void hungry(int philosopherId, long long) override {
+        state[philosopherId] = HUNGRY;
+        test(philosopherId);
+    }
+
+    void release(int philosopherId) override {
+        state[philosopherId] = THINKING;
+        for (int neighbor : graph.neighbors[philosopherId]) {
+            test(neighbor);
+        }
+    }
+
+    void leave(int philosopherId) override {
+        // A grant not yet handed out in round() is dropped with the philosopher
+        pending.erase(remove(pending.begin(), pending.end(), philosopherId), pending.end());
+        if (state[philosopherId] == EATING) release(philosopherId);
+        state[philosopherId] = AWAY;
+    }
+
+    void round(vector<int>& granted) override {
+        granted.insert(granted.end(), pending.begin(), pending.end());
+        pending.clear();
+    }
+};
+
+// queue.cpp: strict FIFO, only the head of the queue may take chopsticks
+class QueueEngine : public Engine {
+private:
+    const ConflictGraph& graph;
+    vector<State> state;
+    deque<int> waitingPhilosophers;
+    vector<int> pending;
+
+    bool canEat(int philosopherId) const {
+        for (int neighbor : graph.neighbors[philosopherId]) {
+            if (state[neighbor] == EATING) return false;
+        }
+        return true;
+    }
+
+    void grantHead() {
+        while (!waitingPhilosophers.empty() && canEat(waitingPhilosophers.front())) {
+            int id = waitingPhilosophers.front();
+            waitingPhilosophers.pop_front();
+            state[id] = EATING;
+            pending.push_back(id);
+        }
+    }
+
+public:
+    explicit QueueEngine(const ConflictGraph& g) : graph(g), state(g.size(), THINKING) {}
+
+    string name() const override { return "queue"; }
+
+    void hungry(int philosopherId, long long) override {
+        state[philosopherId] = HUNGRY;
+        waitingPhilosophers.push_back(philosopherId);
+        grantHead();
+    }
+
+    void release(int philosopherId) override {
+        state[philosopherId] = THINKING;
+        grantHead();
+    }
+
+    void leave(int philosopherId) override {
+        pending.erase(remove(pending.begin(), pending.end(), philosopherId), pending.end());
+        waitingPhilosophers.erase(remove(waitingPhilosophers.begin(), waitingPhilosophers.end(), philosopherId),
+                                  waitingPhilosophers.end());
+        state[philosopherId] = AWAY;
+        grantHead(); // Either the chopsticks or the head of the queue may have changed
+    }
+
+    void round(vector<int>& granted) override {
+        granted.insert(granted.end(), pending.begin(), pending.end());
+        pending.clear();
+    }
+};
+
+struct SimulationResult {
+    long long meals = 0;
+    double mealsPerSecond = 0;
+    double utilization = 0;      // Average fraction of chopsticks in use
+    double averageWait = 0;      // Ticks from hungry to eating
+    double nsPerEvent = 0;       // Wall-clock scheduler cost
+    long long badGrants = 0;     // Grants to a philosopher not hungry or next to an eater; must stay 0
+    long long gaveUp = 0;        // Hungry philosophers that left before being served
+    long long brokenSets = 0;    // Eaters next to an eater after someone gave up; must stay 0
+};
+
+// Drives one engine through a heavy-load workload. After a meal a philosopher sometimes
+// leaves the table and comes back later, now and then one walks out in the middle of a
+// meal, and some hungry philosophers give up and leave if they are not served in time; the
+// engines see all three as incremental updates.
+SimulationResult simulate(Engine& engine, const ConflictGraph& graph, long long ticks, unsigned seed) {
+    const int n = graph.size();
+    const int maxDuration = 64;
+    mt19937 gen(seed);
+    uniform_int_distribution<> eatTime{5, 20};
+    uniform_int_distribution<> thinkTime{1, 5};
+    uniform_int_distribution<> awayTime{20, 60};
+    bernoulli_distribution leaves{0.01};
+    bernoulli_distribution walksOut{0.002};
+    bernoulli_distribution impatient{0.05};
+    uniform_int_distribution<> patience{2, 16};
+
+    vector<State> state(n, THINKING);
+    vector<long long> hungrySince(n, 0);
+    vector<bool> walkingOut(n, false);
+    vector<long long> giveUpAt(n, -1);
+    // Timing wheels: philosophers whose current activity ends at a given tick, and hungry
+    // philosophers who give up at a given tick unless they were served first
+    vector<vector<int>> wheel(maxDuration + 1);
+    vector<vector<int>> giveUpWheel(maxDuration + 1);
+    for (int i = 0; i < n; i++) {
+        wheel[thinkTime(gen)].push_back(i);
+    }
+
+    SimulationResult result;
+    long long eatingNow = 0, eatingTicks = 0, waitTicks = 0, events = 0;
+    vector<int> granted;
+    auto wallStart = chrono::steady_clock::now();
+
+    for (long long tick = 0; tick < ticks; tick++) {
+        vector<int> due;
+        due.swap(wheel[tick % wheel.size()]);
+
+        for (int id : due) {
+            events++;
+            if (state[id] == EATING && walkingOut[id]) {
+                // Leaves with the chopsticks still in hand; the meal does not count
+                walkingOut[id] = false;
+                engine.leave(id);
+                eatingNow--;
+                state[id] = AWAY;
+                wheel[(tick + awayTime(gen)) % wheel.size()].push_back(id);
+            } else if (state[id] == EATING) {
+                engine.release(id);
+                eatingNow--;
+                result.meals++;
+                if (leaves(gen)) {
+                    engine.leave(id);
+                    state[id] = AWAY;
+                    wheel[(tick + awayTime(gen)) % wheel.size()].push_back(id);
+                } else {
+                    state[id] = THINKING;
+                    wheel[(tick + thinkTime(gen)) % wheel.size()].push_back(id);
+                }
+            } else {
+                // Done thinking, or back at the table after being away
+                state[id] = HUNGRY;
+                hungrySince[id] = tick;
+                engine.hungry(id, tick);
+                if (impatient(gen)) {
+                    giveUpAt[id] = tick + patience(gen);
+                    giveUpWheel[giveUpAt[id] % giveUpWheel.size()].push_back(id);
+                }
+            }
+        }
+
+        vector<int> gaveUp;
+        due.clear();
+        due.swap(giveUpWheel[tick % giveUpWheel.size()]);
+        for (int id : due) {
+            // Entries of philosophers served since are stale
+            if (state[id] != HUNGRY || giveUpAt[id] != tick) continue;
+            events++;
+            engine.leave(id);
+            state[id] = AWAY;
+            gaveUp.push_back(id);
+            result.gaveUp++;
+            wheel[(tick + awayTime(gen)) % wheel.size()].push_back(id);
+        }
+
+        granted.clear();
+        engine.round(granted);
+        for (int id : granted) {
+            bool conflict = state[id] != HUNGRY;
+            for (int neighbor : graph.neighbors[id]) {
+                conflict |= state[neighbor] == EATING;
+            }
+            result.badGrants += conflict;
+
+            state[id] = EATING;
+            walkingOut[id] = walksOut(gen);
+            eatingNow++;
+            waitTicks += tick - hungrySince[id];
+            wheel[(tick + eatTime(gen)) % wheel.size()].push_back(id);
+        }
+
+        // The eaters around someone who gave up must still form an independent set
+        for (int id : gaveUp) {
+            for (int neighbor : graph.neighbors[id]) {
+                if (state[neighbor] != EATING) continue;
+                for (int other : graph.neighbors[neighbor]) {
+                    result.brokenSets += state[other] == EATING;
+                }
+            }
+        }
+        eatingTicks += eatingNow;
+    }
+
+    double wallNs = chrono::duration<double, nano>(chrono::steady_clock::now() - wallStart).count();
+    long long grants = result.meals + eatingNow;
+    result.mealsPerSecond = result.meals / (ticks / 1000.0);
+    result.utilization = 2.0 * eatingTicks / ((double)ticks * graph.chopsticks);
+    result.averageWait = grants ? (double)waitTicks / grants : 0;
+    result.nsPerEvent = events ? wallNs / events : 0;
+    return result;
+}
+
+// Usage: round-based [ticks] [N...]
+// Every size runs on the ring and on a random conflict graph of the same size.
+int main(int argc, char* argv[]) {
+    long long ticks = argc > 1 ? stoll(argv[1]) : 5000;
+    vector<int> sizes;
+    for (int i = 2; i < argc; i++) sizes.push_back(stoi(argv[i]));
+    if (sizes.empty()) sizes = {1000, 10000, 100000};
+
+    ostringstream header;
+    header << left << setw(10) << "engine" << setw(8) << "graph" << right << setw(10) << "N" << setw(14) << "meals/s"
+           << setw(14) << "utilization" << setw(14) << "avg wait ms" << setw(14) << "ns/event"
+           << setw(10) << "gave up" << setw(12) << "bad grants";
+    cout << "\033[36m" << header.str() << "\033[0m" << endl;
+
+    for (int n : sizes) {
+        for (string graphName : {"ring", "random"}) {
+            ConflictGraph graph = graphName == "ring" ? ConflictGraph::ring(n) : ConflictGraph::random(n, n);
+            RoundEngine roundEngine(graph);
+            DijkstraEngine dijkstraEngine(graph);
+            QueueEngine queueEngine(graph);
+
+            for (Engine* engine : {(Engine*)&roundEngine, (Engine*)&dijkstraEngine, (Engine*)&queueEngine}) {
+                SimulationResult r = simulate(*engine, graph, ticks, n);
+
+                ostringstream row;
+                row << left << setw(10) << engine->name() << setw(8) << graphName << right << setw(10) << n
+                    << setw(14) << fixed << setprecision(0) << r.mealsPerSecond
+                    << setw(13) << setprecision(1) << r.utilization * 100 << "%"
+                    << setw(14) << setprecision(2) << r.averageWait
+                    << setw(14) << setprecision(1) << r.nsPerEvent
+                    << setw(10) << r.gaveUp << setw(12) << r.badGrants + r.brokenSets;
+                int color = r.badGrants + r.brokenSets ? 31 : engine == &roundEngine ? 32 : 33;
+                cout << "\033[" << color << "m" << row.str() << "\033[0m" << endl;
+            }
+        }
+    }
+
+    cout << "\033[32mSimulation complete!\033[0m" << endl;
+    return 0;
+}
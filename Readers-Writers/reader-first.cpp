@@ -1,17 +1,25 @@
 #include <iostream> 
-#include <thread> 
+#include <thread>
+#include <atomic> 
 #include <mutex> 
 #include <condition_variable> 
 #include <vector> 
 #include <chrono> 
 
-std::mutex resource_mutex; // Mutex for protecting shared resource access
+#include "../placement.h"
+#include "../queue_locks.h"
+#include "../cpu_accounting.h"
+
+queue_locks::ExclusiveLock resource_mutex; // Mutex for protecting shared resource access
 std::mutex reader_count_mutex; // Mutex for protecting reader count variable
+std::mutex upgrader_mutex; // Mutex allowing at most one upgradable reader at a time
 std::mutex cout_mutex; // Mutex for thread-safe printing
 std::condition_variable cv; // Condition variable for thread synchronization
 
 int reader_count = 0; // Global variable to keep track of reader count
 int shared_memory = 0; // Shared integer memory
+bool upgrade_pending = false; // Flag to indicate an upgrader is waiting for readers to drain
+std::atomic<bool> running{true}; // Cleared when the simulation ends
 
 // Thread-safe function for printing with color
 enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
@@ -22,9 +30,11 @@ void atomicPrint(const std::string& message, Color color = WHITE) {
 }
 
 void read(int reader_id) { 
-    while (true) { 
+    cpu_accounting::Scope account("Reader " + std::to_string(reader_id));
+    while (running) { 
         {
             std::unique_lock<std::mutex> lock(reader_count_mutex);
+            cv.wait(lock, cpu_accounting::counted([] { return !upgrade_pending; })); // Wait if an upgrader is converting to writer
             reader_count++; 
             if (reader_count == 1) {
                 resource_mutex.lock(); 
@@ -40,15 +50,19 @@ void read(int reader_id) {
             reader_count--; 
             if (reader_count == 0) {
                 resource_mutex.unlock(); 
+            } else if (reader_count == 1 && upgrade_pending) {
+                cv.notify_all(); // Only the upgrader is left
             }
         }
 
+        cpu_accounting::work();
         std::this_thread::sleep_for(std::chrono::milliseconds(200)); // Pause before next read
     }
 }
 
 void write(int writer_id) { 
-    while (true) { 
+    cpu_accounting::Scope account("Writer " + std::to_string(writer_id));
+    while (running) { 
         resource_mutex.lock(); 
 
         shared_memory += 1; // Update shared memory
@@ -57,21 +71,88 @@ void write(int writer_id) {
         atomicPrint("Writer " + std::to_string(writer_id) + " has finished writing.", MAGENTA); 
         
         resource_mutex.unlock(); 
+        cpu_accounting::work();
         std::this_thread::sleep_for(std::chrono::milliseconds(300)); // Pause before next write
     }
 }
 
+// Reads like a reader, then decides whether to write based on what it read.
+// Upgrading keeps resource_mutex locked, so no writer can change shared_memory in between.
+// Benchmarks/upgradable.cpp measures a copy of this protocol; keep the two in step.
+void upgrade(int upgrader_id) {
+    cpu_accounting::Scope account("Upgrader " + std::to_string(upgrader_id));
+    while (running) {
+        upgrader_mutex.lock(); // At most one upgradable reader; plain readers still share the resource
+
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            reader_count++;
+            if (reader_count == 1) {
+                resource_mutex.lock();
+            }
+        }
+
+        int observed = shared_memory;
+        atomicPrint("Upgrader " + std::to_string(upgrader_id) + " is reading.", BLUE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (observed % 2 == 0) { // Decide to update based on the value read
+            {
+                std::unique_lock<std::mutex> lock(reader_count_mutex);
+                upgrade_pending = true; // Hold off new readers
+                cv.wait(lock, cpu_accounting::counted([] { return reader_count == 1; })); // Wait for the other readers to drain
+                reader_count--; // resource_mutex stays locked: now held exclusively
+            }
+
+            shared_memory = observed + 1; // The value read is still current
+            atomicPrint("Upgrader " + std::to_string(upgrader_id) + " upgraded and is writing.", RED);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            atomicPrint("Upgrader " + std::to_string(upgrader_id) + " has finished writing.", MAGENTA);
+
+            resource_mutex.unlock();
+
+            {
+                std::unique_lock<std::mutex> lock(reader_count_mutex);
+                upgrade_pending = false;
+                cv.notify_all(); // Notify readers held off by the upgrade
+            }
+        } else {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            atomicPrint("Upgrader " + std::to_string(upgrader_id) + " has finished reading without writing.", CYAN);
+            reader_count--;
+            if (reader_count == 0) {
+                resource_mutex.unlock();
+            }
+        }
+
+        upgrader_mutex.unlock();
+        cpu_accounting::work();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300)); // Pause before next read-modify-write
+    }
+}
+
 int main() { 
     const int simulation_duration = 30; // Simulation time in seconds
     const auto start_time = std::chrono::steady_clock::now(); 
 
     std::vector<std::thread> readers; 
     std::vector<std::thread> writers; 
+    std::vector<std::thread> upgraders; 
 
     for (int i = 1; i <= 5; ++i) { 
         readers.push_back(std::thread(read, i)); 
         writers.push_back(std::thread(write, i)); 
     }
+    for (int i = 1; i <= 2; ++i) {
+        upgraders.push_back(std::thread(upgrade, i));
+    }
+
+    // Pin threads according to PLACEMENT: readers, then writers, then upgraders
+    int actor = 0;
+    int actors = readers.size() + writers.size() + upgraders.size();
+    for (auto& t : readers) placement::place(t, actor++, actors);
+    for (auto& t : writers) placement::place(t, actor++, actors);
+    for (auto& t : upgraders) placement::place(t, actor++, actors);
 
     // Run simulation for the specified duration
     while (std::chrono::duration_cast<std::chrono::seconds>(
@@ -80,9 +161,16 @@ int main() {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
-    // Stop threads after simulation ends
-    for (auto& t : readers) t.detach(); 
-    for (auto& t : writers) t.detach(); 
+    // Stop threads after simulation ends. Every wait is released by a round already in
+    // progress, so each thread finishes its round and returns.
+    running = false;
+    for (auto& t : readers) t.join();
+    for (auto& t : writers) t.join();
+    for (auto& t : upgraders) t.join();
+
+    for (const std::string& line : cpu_accounting::ledger().report("reader-first", "op")) {
+        atomicPrint(line, CYAN);
+    }
 
     atomicPrint("Simulation complete!", YELLOW); 
 
@@ -0,0 +1,329 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <algorithm>
+
+#include "../placement.h"
+#include "../rw_policy.h"
+#include "../cpu_accounting.h"
+
+// One reader-writer lock that picks its own preference at runtime.
+// It samples read/write arrival rates and queue depths and moves between the modes of
+// rw_policy.h (READER_BIASED, WRITER_BIASED, PHASE_FAIR).
+// Upgradable readers (rw_policy.h) count as reads in the samples.
+// Switching is safe while the lock is held: the mode only changes which waiter is admitted
+// next. "No reader while writing, one writer at a time" is checked the same way in every
+// mode, and the switch itself happens under state_mutex.
+
+using Clock = std::chrono::steady_clock;
+
+std::mutex cout_mutex; // Mutex for thread-safe printing
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    std::lock_guard<std::mutex> lock(cout_mutex);
+    std::cout << "\033[" << color << "m" << message << "\033[0m" << std::endl;
+}
+
+using rw_policy::Mode;
+using rw_policy::mode_name;
+using rw_policy::READER_BIASED;
+using rw_policy::WRITER_BIASED;
+using rw_policy::PHASE_FAIR;
+
+class AdaptiveLock {
+    std::mutex state_mutex;             // Protects everything below
+    std::condition_variable cv;         // Readers and writers wait here
+
+    rw_policy::Counts counts;
+
+    Mode current_mode;
+    const bool adaptive;
+    int switch_count = 0;
+    int pending_votes = 0;              // Consecutive samples voting for the same new mode
+    Mode pending_mode;
+
+    // Sampling window
+    const std::chrono::milliseconds sample_interval{50};
+    Clock::time_point window_start = Clock::now();
+    long long window_reads = 0;
+    long long window_writes = 0;
+    long long window_reader_depth = 0;  // Sum of waiting readers seen at each arrival
+    long long window_writer_depth = 0;  // Sum of waiting writers seen at each arrival
+
+    // Must be called with state_mutex held
+    void sample_arrival(bool is_writer) {
+        (is_writer ? window_writes : window_reads)++;
+        window_reader_depth += counts.waiting_readers;
+        window_writer_depth += counts.waiting_writers;
+
+        auto now = Clock::now();
+        if (!adaptive || now - window_start < sample_interval) return;
+
+        long long arrivals = window_reads + window_writes;
+        double write_fraction = arrivals ? (double)window_writes / arrivals : 0;
+        double reader_depth = arrivals ? (double)window_reader_depth / arrivals : 0;
+        double writer_depth = arrivals ? (double)window_writer_depth / arrivals : 0;
+
+        // Both sides queueing up: alternate so neither starves. Otherwise favour whichever
+        // side the traffic comes from.
+        Mode wanted;
+        if (reader_depth >= 1.0 && writer_depth >= 1.0) wanted = PHASE_FAIR;
+        else if (write_fraction >= 0.3) wanted = WRITER_BIASED;
+        else wanted = READER_BIASED;
+
+        // Hysteresis: only switch after two samples in a row agree
+        if (wanted == current_mode) {
+            pending_votes = 0;
+        } else if (pending_votes > 0 && wanted == pending_mode) {
+            switch_mode(wanted);
+        } else {
+            pending_mode = wanted;
+            pending_votes = 1;
+        }
+
+        window_start = now;
+        window_reads = window_writes = window_reader_depth = window_writer_depth = 0;
+    }
+
+    // Must be called with state_mutex held
+    void switch_mode(Mode mode) {
+        atomicPrint(std::string("Lock switches from ") + mode_name(current_mode) + " to " + mode_name(mode), BLUE);
+        current_mode = mode;
+        counts.reader_turn = 0;
+        pending_votes = 0;
+        switch_count++;
+        cv.notify_all(); // Every waiter re-evaluates under the new mode
+    }
+
+public:
+    // adaptive == false pins the lock to `mode`, for comparison with the fixed policies
+    explicit AdaptiveLock(Mode mode = READER_BIASED, bool adaptive = true)
+        : current_mode(mode), adaptive(adaptive), pending_mode(mode) {}
+
+    void read_lock() {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        sample_arrival(false);
+        unsigned arrival_phase = counts.write_phase;
+        counts.waiting_readers++;
+        cv.wait(lock, cpu_accounting::counted([&] { return rw_policy::reader_may_enter(current_mode, counts, arrival_phase); }));
+        rw_policy::reader_entered(counts, arrival_phase);
+    }
+
+    void read_unlock() {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        counts.active_readers--;
+        if (counts.active_readers <= 1) cv.notify_all(); // Notify waiting writers, or a pending upgrade
+    }
+
+    void write_lock() {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        sample_arrival(true);
+        counts.waiting_writers++;
+        cv.wait(lock, cpu_accounting::counted([&] { return rw_policy::writer_may_enter(current_mode, counts); }));
+        rw_policy::writer_entered(counts);
+    }
+
+    void write_unlock() {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        rw_policy::write_finished(current_mode, counts);
+        cv.notify_all(); // Notify waiting readers or writers
+    }
+
+    void upgradable_lock() {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        sample_arrival(false);
+        unsigned arrival_phase = counts.write_phase;
+        counts.waiting_readers++;
+        cv.wait(lock, cpu_accounting::counted([&] { return rw_policy::upgrader_may_enter(current_mode, counts, arrival_phase); }));
+        rw_policy::upgrader_entered(counts, arrival_phase);
+    }
+
+    void upgradable_unlock() {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        rw_policy::upgrader_left(counts);
+        cv.notify_all(); // Notify waiting writers and the next upgradable reader
+    }
+
+    // Turns the upgradable read hold into a write hold; release it with write_unlock()
+    void upgrade() {
+        std::unique_lock<std::mutex> lock(state_mutex);
+        counts.upgrade_pending = true; // Hold off new readers
+        cv.wait(lock, cpu_accounting::counted([&] { return rw_policy::upgrade_may_complete(counts); }));
+        rw_policy::upgrade_completed(counts);
+    }
+
+    Mode mode() {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        return current_mode;
+    }
+
+    int switches() {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        return switch_count;
+    }
+};
+
+// ---------------------------------------------------------------------------------------
+// Workload whose read/write mix shifts during the run
+
+struct WorkloadPhase {
+    const char* name;
+    int reader_pause_us;   // Pause between reads
+    int writer_pause_us;   // Pause between writes
+};
+
+const WorkloadPhase phases[] = {
+    {"read-heavy", 200, 20000},
+    {"write-heavy", 5000, 300},
+    {"mixed", 400, 400},
+};
+constexpr int num_phases = sizeof(phases) / sizeof(phases[0]);
+
+struct PhaseStats {
+    std::atomic<long long> reads{0};
+    std::atomic<long long> writes{0};
+    std::atomic<long long> upgrades{0};
+    std::atomic<long long> max_read_wait_us{0};
+    std::atomic<long long> max_write_wait_us{0};
+};
+
+void record_max(std::atomic<long long>& target, long long value) {
+    long long seen = target.load();
+    while (value > seen && !target.compare_exchange_weak(seen, value)) {
+    }
+}
+
+void run(const std::string& label, AdaptiveLock& lock, std::chrono::milliseconds phase_length) {
+    const int num_readers = 6;
+    const int num_writers = 3;
+    const int num_upgraders = 2;
+    int shared_memory = 0; // Shared integer memory
+    std::atomic<int> phase{0};
+    std::atomic<bool> done{false};
+    PhaseStats stats[num_phases];
+    cpu_accounting::Ledger ledger;
+    std::vector<std::thread> readers;
+    std::vector<std::thread> writers;
+    std::vector<std::thread> upgraders;
+
+    for (int i = 0; i < num_readers; ++i) {
+        readers.emplace_back([&, i] {
+            cpu_accounting::Scope account(ledger, "Reader " + std::to_string(i + 1));
+            int observed = 0;
+            while (!done) {
+                int p = phase;
+                auto start = Clock::now();
+                lock.read_lock();
+                record_max(stats[p].max_read_wait_us, std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+                observed += shared_memory;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                lock.read_unlock();
+                stats[p].reads++;
+                cpu_accounting::work();
+                std::this_thread::sleep_for(std::chrono::microseconds(phases[p].reader_pause_us)); // Pause before next read
+            }
+            (void)observed;
+        });
+    }
+    for (int i = 0; i < num_writers; ++i) {
+        writers.emplace_back([&, i] {
+            cpu_accounting::Scope account(ledger, "Writer " + std::to_string(i + 1));
+            while (!done) {
+                int p = phase;
+                auto start = Clock::now();
+                lock.write_lock();
+                record_max(stats[p].max_write_wait_us, std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+                shared_memory += 1; // Update shared memory
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                lock.write_unlock();
+                stats[p].writes++;
+                cpu_accounting::work();
+                std::this_thread::sleep_for(std::chrono::microseconds(phases[p].writer_pause_us)); // Pause before next write
+            }
+        });
+    }
+
+    // Upgraders read like readers, and write what they read plus one when it is even
+    for (int i = 0; i < num_upgraders; ++i) {
+        upgraders.emplace_back([&, i] {
+            cpu_accounting::Scope account(ledger, "Upgrader " + std::to_string(i + 1));
+            while (!done) {
+                int p = phase;
+                lock.upgradable_lock();
+                int observed = shared_memory;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                if (observed % 2 == 0) {
+                    lock.upgrade();
+                    shared_memory = observed + 1; // The value read is still current
+                    lock.write_unlock();
+                    stats[p].upgrades++;
+                } else {
+                    lock.upgradable_unlock();
+                }
+                cpu_accounting::work();
+                std::this_thread::sleep_for(std::chrono::microseconds(phases[p].reader_pause_us)); // Pause before next read-modify-write
+            }
+        });
+    }
+
+    // Pin threads according to PLACEMENT: readers, then writers, then upgraders
+    int actor = 0;
+    int actors = readers.size() + writers.size() + upgraders.size();
+    for (auto& t : readers) placement::place(t, actor++, actors);
+    for (auto& t : writers) placement::place(t, actor++, actors);
+    for (auto& t : upgraders) placement::place(t, actor++, actors);
+
+    for (int p = 0; p < num_phases; ++p) {
+        phase = p;
+        std::this_thread::sleep_for(phase_length);
+        std::ostringstream row;
+        row << std::left << std::setw(22) << label << std::setw(13) << phases[p].name
+            << std::right << std::setw(10) << stats[p].reads << std::setw(10) << stats[p].writes << std::setw(10) << stats[p].upgrades
+            << std::setw(14) << stats[p].max_read_wait_us / 1000.0 << std::setw(14) << stats[p].max_write_wait_us / 1000.0
+            << "  " << mode_name(lock.mode());
+        atomicPrint(row.str(), p % 2 ? GREEN : CYAN);
+    }
+
+    done = true;
+    for (auto& t : readers) t.join();
+    for (auto& t : writers) t.join();
+    for (auto& t : upgraders) t.join();
+
+    cpu_accounting::Totals cost = ledger.totals();
+    std::ostringstream summary;
+    summary << label << ": " << lock.switches() << " mode switch(es), " << std::fixed << std::setprecision(1)
+            << cost.cpu_us_per_unit() << " CPU-us per op, " << cost.wasted << " of " << cost.wakeups << " wakeups wasted, "
+            << cost.usage.voluntary << " voluntary / " << cost.usage.involuntary << " involuntary context switches";
+    atomicPrint(summary.str(), YELLOW);
+}
+
+// Usage: reader-writer-adaptive [milliseconds-per-phase]
+int main(int argc, char* argv[]) {
+    std::chrono::milliseconds phase_length(argc > 1 ? std::stoi(argv[1]) : 2000);
+
+    std::ostringstream header;
+    header << std::left << std::setw(22) << "lock" << std::setw(13) << "phase"
+           << std::right << std::setw(10) << "reads" << std::setw(10) << "writes" << std::setw(10) << "upgrades"
+           << std::setw(14) << "max read ms" << std::setw(14) << "max write ms" << "  mode at end";
+    atomicPrint(header.str(), MAGENTA);
+
+    for (Mode mode : {READER_BIASED, WRITER_BIASED, PHASE_FAIR}) {
+        AdaptiveLock fixed(mode, false);
+        run(std::string("fixed ") + mode_name(mode), fixed, phase_length);
+    }
+    AdaptiveLock adaptive;
+    run("adaptive", adaptive, phase_length);
+
+    atomicPrint("Simulation complete!", YELLOW);
+    return 0;
+}
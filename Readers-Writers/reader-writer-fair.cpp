@@ -1,19 +1,29 @@
 #include <iostream>
 #include <thread>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <vector>
 #include <chrono>
 #include <random>
 
-std::mutex resource_mutex;          // Mutex for protecting shared resource access
+#include "../placement.h"
+#include "../queue_locks.h"
+#include "../cpu_accounting.h"
+
+queue_locks::ExclusiveLock resource_mutex;          // Mutex for protecting shared resource access
 std::mutex reader_count_mutex;      // Mutex for protecting reader count variable
+std::mutex upgrader_mutex;          // Mutex allowing at most one upgradable reader at a time
 std::mutex cout_mutex;              // Mutex for thread-safe printing
 std::condition_variable cv;         // Condition variable for thread synchronization
 
 int reader_count = 0;               // Global variable to keep track of reader count
 bool writer_active = false;         // Flag to indicate if a writer is active
+bool upgrade_pending = false;       // Flag to indicate an upgrader is waiting for readers to drain
+int writers_waiting = 0;            // Writers waiting for the readers to leave
+bool writer_turn = false;           // A read ended with writers waiting: one writes before new readers enter
 int shared_memory = 0;              // Shared integer memory
+std::atomic<bool> running{true};    // Cleared when the simulation ends
 
 int random(int min, int max) {
     // Ensure min is less than or equal to max
@@ -38,10 +48,11 @@ void atomicPrint(const std::string& message, Color color = WHITE) {
 }
 
 void read(int reader_id) {
-    while (true) {
+    cpu_accounting::Scope account("Reader " + std::to_string(reader_id));
+    while (running) {
         {
             std::unique_lock<std::mutex> lock(reader_count_mutex);
-            cv.wait(lock, [] { return !writer_active; }); // Wait if a writer is active
+            cv.wait(lock, cpu_accounting::counted([] { return !writer_active && !upgrade_pending && !writer_turn; })); // Wait if a writer is active or has the next turn, or an upgrader is converting
             reader_count++;
         }
 
@@ -54,21 +65,27 @@ void read(int reader_id) {
         {
             std::unique_lock<std::mutex> lock(reader_count_mutex);
             reader_count--;
-            if (reader_count == 0) {
-                cv.notify_all(); // Notify waiting writers
+            writer_turn = writers_waiting > 0; // New readers wait until a queued writer has written
+            if (reader_count == 0 || (reader_count == 1 && upgrade_pending)) {
+                cv.notify_all(); // Notify waiting writers, or the upgrader once it is the only reader left
             }
         }
 
+        cpu_accounting::work();
         std::this_thread::sleep_for(std::chrono::milliseconds(random(200, 500))); // Pause before next read
     }
 }
 
 void write(int writer_id) {
-    while (true) {
+    cpu_accounting::Scope account("Writer " + std::to_string(writer_id));
+    while (running) {
         {
             std::unique_lock<std::mutex> lock(reader_count_mutex);
-            cv.wait(lock, [] { return !writer_active && reader_count == 0; }); // Wait if readers are active or a writer is active
+            writers_waiting++;
+            cv.wait(lock, cpu_accounting::counted([] { return !writer_active && reader_count == 0; })); // Wait if readers are active or a writer is active
+            writers_waiting--;
             writer_active = true;
+            writer_turn = false;
         }
 
         resource_mutex.lock(); // Lock resource for writing
@@ -84,21 +101,95 @@ void write(int writer_id) {
             cv.notify_all(); // Notify waiting readers or writers
         }
 
+        cpu_accounting::work();
         std::this_thread::sleep_for(std::chrono::milliseconds(random(100, 300))); // Pause before next write
     }
 }
 
+// Reads like a reader, then decides whether to write based on what it read.
+// The switch from reader to writer happens in one step under reader_count_mutex,
+// so no writer can change shared_memory in between. Like every read, an upgradable read that
+// ends with writers queued gives one of them the next turn, so back-to-back upgradable reads
+// cannot keep reader_count above 0 and starve the writers.
+// Benchmarks/upgradable.cpp measures a copy of this protocol; keep the two in step.
+void upgrade(int upgrader_id) {
+    cpu_accounting::Scope account("Upgrader " + std::to_string(upgrader_id));
+    while (running) {
+        upgrader_mutex.lock(); // At most one upgradable reader; plain readers still get in
+
+        {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            cv.wait(lock, cpu_accounting::counted([] { return !writer_active && !writer_turn; })); // Wait if a writer is active or has the next turn
+            reader_count++;
+        }
+
+        resource_mutex.lock(); // Lock resource for individual reading
+        int observed = shared_memory;
+        atomicPrint("Upgrader " + std::to_string(upgrader_id) + " is reading.", BLUE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        resource_mutex.unlock(); // Unlock resource after reading
+
+        if (observed % 2 == 0) { // Decide to update based on the value read
+            {
+                std::unique_lock<std::mutex> lock(reader_count_mutex);
+                upgrade_pending = true; // Hold off new readers
+                cv.wait(lock, cpu_accounting::counted([] { return reader_count == 1; })); // Wait for the other readers to drain
+                reader_count--;
+                writer_active = true; // Reader -> writer without letting a writer in
+                upgrade_pending = false;
+            }
+
+            resource_mutex.lock(); // Lock resource for writing
+            shared_memory = observed + 1; // The value read is still current
+            atomicPrint("Upgrader " + std::to_string(upgrader_id) + " upgraded and is writing.", RED);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            atomicPrint("Upgrader " + std::to_string(upgrader_id) + " has finished writing.", MAGENTA);
+            resource_mutex.unlock(); // Unlock resource after writing
+
+            {
+                std::unique_lock<std::mutex> lock(reader_count_mutex);
+                writer_active = false;
+                writer_turn = writers_waiting > 0; // Readers held off by the upgrade let a queued writer in first
+                cv.notify_all(); // Notify waiting readers or writers
+            }
+        } else {
+            std::unique_lock<std::mutex> lock(reader_count_mutex);
+            atomicPrint("Upgrader " + std::to_string(upgrader_id) + " has finished reading without writing.", CYAN);
+            reader_count--;
+            writer_turn = writers_waiting > 0; // New readers wait until a queued writer has written
+            if (reader_count == 0) {
+                cv.notify_all(); // Notify waiting writers
+            }
+        }
+
+        upgrader_mutex.unlock();
+        cpu_accounting::work();
+        std::this_thread::sleep_for(std::chrono::milliseconds(random(1000, 2000))); // Pause before next read-modify-write
+    }
+}
+
 int main() {
     const int simulation_duration = 10; // Simulation time in seconds
     const auto start_time = std::chrono::steady_clock::now();
 
     std::vector<std::thread> readers;
     std::vector<std::thread> writers;
+    std::vector<std::thread> upgraders;
 
     for (int i = 1; i <= 5; ++i) {
         writers.push_back(std::thread(write, i));
         readers.push_back(std::thread(read, i));
     }
+    for (int i = 1; i <= 2; ++i) {
+        upgraders.push_back(std::thread(upgrade, i));
+    }
+
+    // Pin threads according to PLACEMENT: readers, then writers, then upgraders
+    int actor = 0;
+    int actors = readers.size() + writers.size() + upgraders.size();
+    for (auto& t : readers) placement::place(t, actor++, actors);
+    for (auto& t : writers) placement::place(t, actor++, actors);
+    for (auto& t : upgraders) placement::place(t, actor++, actors);
 
     // Run simulation for the specified duration
     while (std::chrono::duration_cast<std::chrono::seconds>(
@@ -107,9 +198,16 @@ int main() {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
-    // Stop threads after simulation ends
-    for (auto& t : readers) t.detach();
-    for (auto& t : writers) t.detach();
+    // Stop threads after simulation ends. Every wait is released by a round already in
+    // progress, so each thread finishes its round and returns.
+    running = false;
+    for (auto& t : readers) t.join();
+    for (auto& t : writers) t.join();
+    for (auto& t : upgraders) t.join();
+
+    for (const std::string& line : cpu_accounting::ledger().report("fair", "op")) {
+        atomicPrint(line, CYAN);
+    }
 
     atomicPrint("Simulation complete!", YELLOW);
 
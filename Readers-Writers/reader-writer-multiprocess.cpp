@@ -0,0 +1,442 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "../placement.h"
+#include "../cpu_accounting.h"
+#include "../rw_policy.h"
+#include "../shared_segment.h"
+
+// Readers and writers run as separate processes. All lock state lives in one mmap'ed
+// MAP_SHARED segment, so every process sees the same counters and the same shared_memory.
+//
+// - state_mutex is a process-shared *robust* pthread mutex (a futex underneath). If a process
+//   dies while holding it, the next locker gets EOWNERDEAD and repairs the state.
+// - Waiting is done on a shm::Channel (a non-private futex word in the segment).
+// - Every worker holds its own robust "alive" mutex for its whole life. Trying that mutex
+//   tells us whether the worker died, so a reader or writer killed in the middle of its
+//   critical section is detected and its read/write hold is released.
+// - The admission rules are the ones of rw_policy.h, as in reader-writer-adaptive.cpp.
+//
+// Crash consistency: each worker's slot records what it is doing (waiting to read, reading,
+// waiting to write, writing, and the upgradable reader's steps) in a single field. The counts in rw_policy::Counts are only a
+// cache of those slots; after a death they are rebuilt from the slots of the live workers,
+// so it does not matter at which step of an update the dead worker stopped.
+//
+// CPU accounting: each worker counts its operations and wakeups into its slot, and the parent
+// reaps it with wait4(), which returns the child's CPU time and context switches. A wakeup is
+// wasted when the worker still may not enter, e.g. after one of wait_for_change's timeouts.
+
+constexpr int MAX_WORKERS = 64;
+
+enum Activity {
+    IDLE = 0, WAITING_TO_READ = 1, READING = 2, WAITING_TO_WRITE = 3, WRITING = 4,
+    WAITING_TO_READ_UPGRADABLE = 5, READING_UPGRADABLE = 6, UPGRADING = 7
+};
+
+struct WorkerSlot {
+    shm::Liveness liveness;
+    int activity;                   // Activity; written only under state_mutex
+    unsigned arrival_phase;         // write_phase when the worker started waiting to read
+    cpu_accounting::Counters counts;
+};
+
+struct SharedState {
+    pthread_mutex_t state_mutex;            // Protects everything below (robust, process-shared)
+    shm::Channel state_changed;             // Bumped on every release
+
+    int mode;                               // rw_policy::Mode
+    rw_policy::Counts counts;               // Rebuilt from the slots after a crash
+
+    int shared_memory;                      // Shared integer memory
+    long long reads;
+    long long writes;
+    long long upgrades;                     // Writes made by upgrading a read
+    int recovered;                          // Holds released on behalf of dead processes
+
+    WorkerSlot slots[MAX_WORKERS];
+};
+
+// Thread-safe function for printing with color
+enum Color { RED = 31, GREEN = 32, YELLOW = 33, BLUE = 34, MAGENTA = 35, CYAN = 36, WHITE = 37 };
+
+void atomicPrint(const std::string& message, Color color = WHITE) {
+    // One write() per line keeps lines from different processes from interleaving
+    std::string line = "\033[" + std::to_string(color) + "m" + message + "\033[0m\n";
+    ssize_t ignored = ::write(STDOUT_FILENO, line.data(), line.size());
+    (void)ignored;
+}
+
+rw_policy::Mode mode_of(SharedState* s) {
+    return static_cast<rw_policy::Mode>(s->mode);
+}
+
+// Must be called with state_mutex held. Recomputes the counts from the live workers' slots.
+void rebuild_counts(SharedState* s) {
+    rw_policy::Counts& c = s->counts;
+    c.active_readers = c.waiting_readers = c.waiting_writers = c.reader_turn = 0;
+    c.writer_active = c.upgrader_active = c.upgrade_pending = false;
+    for (WorkerSlot& slot : s->slots) {
+        if (slot.liveness.pid == 0) continue;
+        switch (slot.activity) {
+            case WAITING_TO_READ:
+            case WAITING_TO_READ_UPGRADABLE:
+                c.waiting_readers++;
+                // Readers that waited through a write are the ones reader_turn lets in first
+                if (mode_of(s) == rw_policy::PHASE_FAIR && slot.arrival_phase != c.write_phase) c.reader_turn++;
+                break;
+            case READING: c.active_readers++; break;
+            case READING_UPGRADABLE: c.active_readers++; c.upgrader_active = true; break;
+            case UPGRADING: c.active_readers++; c.upgrader_active = c.upgrade_pending = true; break;
+            case WAITING_TO_WRITE: c.waiting_writers++; break;
+            case WRITING: c.writer_active = true; break;
+        }
+    }
+}
+
+// Must be called with state_mutex held. Releases whatever dead workers were holding.
+void reap_dead_workers(SharedState* s, bool force_rebuild = false) {
+    bool changed = false;
+    for (WorkerSlot& slot : s->slots) {
+        if (!slot.liveness.died()) continue;
+
+        if (slot.activity == READING || slot.activity == WRITING || slot.activity == READING_UPGRADABLE
+            || slot.activity == UPGRADING) {
+            s->recovered++;
+        }
+        if (slot.activity == WRITING) s->counts.write_phase++; // As write_unlock would have
+        slot.activity = IDLE;
+        changed = true;
+    }
+    if (changed || force_rebuild) {
+        rebuild_counts(s);
+        s->state_changed.notify_all();
+    }
+}
+
+void lock_state(SharedState* s) {
+    if (shm::lock_robust(&s->state_mutex)) {
+        // The previous owner died inside the critical section; fix up and carry on
+        reap_dead_workers(s, true);
+    }
+}
+
+void unlock_state(SharedState* s) {
+    pthread_mutex_unlock(&s->state_mutex);
+}
+
+// Must be called with state_mutex held; returns with it held again.
+// Times out periodically so a holder that died outside state_mutex is still noticed.
+void wait_for_change(SharedState* s) {
+    uint32_t seen = s->state_changed.snapshot();
+    unlock_state(s);
+    bool notified = s->state_changed.wait(seen, 100);
+    lock_state(s);
+    if (!notified) reap_dead_workers(s);
+}
+
+void read_lock(SharedState* s, WorkerSlot& me) {
+    lock_state(s);
+    me.arrival_phase = s->counts.write_phase;
+    me.activity = WAITING_TO_READ;
+    s->counts.waiting_readers++;
+    auto may_enter = cpu_accounting::counted([&] { return rw_policy::reader_may_enter(mode_of(s), s->counts, me.arrival_phase); });
+    while (!may_enter()) {
+        wait_for_change(s);
+    }
+    me.activity = READING;
+    rw_policy::reader_entered(s->counts, me.arrival_phase);
+    unlock_state(s);
+}
+
+void read_unlock(SharedState* s, WorkerSlot& me) {
+    lock_state(s);
+    me.activity = IDLE;
+    s->counts.active_readers--;
+    if (s->counts.active_readers == 0 || (s->counts.active_readers == 1 && s->counts.upgrade_pending)) {
+        s->state_changed.notify_all(); // Notify waiting writers, or the upgrader once it reads alone
+    }
+    unlock_state(s);
+}
+
+void upgradable_lock(SharedState* s, WorkerSlot& me) {
+    lock_state(s);
+    me.arrival_phase = s->counts.write_phase;
+    me.activity = WAITING_TO_READ_UPGRADABLE;
+    s->counts.waiting_readers++;
+    auto may_enter = cpu_accounting::counted([&] { return rw_policy::upgrader_may_enter(mode_of(s), s->counts, me.arrival_phase); });
+    while (!may_enter()) {
+        wait_for_change(s);
+    }
+    me.activity = READING_UPGRADABLE;
+    rw_policy::upgrader_entered(s->counts, me.arrival_phase);
+    unlock_state(s);
+}
+
+void upgradable_unlock(SharedState* s, WorkerSlot& me) {
+    lock_state(s);
+    me.activity = IDLE;
+    rw_policy::upgrader_left(s->counts);
+    s->state_changed.notify_all(); // Notify waiting writers and the next upgradable reader
+    unlock_state(s);
+}
+
+// Turns the upgradable read hold into a write hold; release it with write_unlock()
+void upgrade(SharedState* s, WorkerSlot& me) {
+    lock_state(s);
+    me.activity = UPGRADING;
+    s->counts.upgrade_pending = true; // Hold off new readers
+    auto may_complete = cpu_accounting::counted([&] { return rw_policy::upgrade_may_complete(s->counts); });
+    while (!may_complete()) {
+        wait_for_change(s);
+    }
+    me.activity = WRITING;
+    rw_policy::upgrade_completed(s->counts);
+    unlock_state(s);
+}
+
+void write_lock(SharedState* s, WorkerSlot& me) {
+    lock_state(s);
+    me.activity = WAITING_TO_WRITE;
+    s->counts.waiting_writers++;
+    auto may_enter = cpu_accounting::counted([&] { return rw_policy::writer_may_enter(mode_of(s), s->counts); });
+    while (!may_enter()) {
+        wait_for_change(s);
+    }
+    me.activity = WRITING;
+    rw_policy::writer_entered(s->counts);
+    unlock_state(s);
+}
+
+void write_unlock(SharedState* s, WorkerSlot& me) {
+    lock_state(s);
+    rw_policy::write_finished(mode_of(s), s->counts);
+    me.activity = IDLE;
+    s->state_changed.notify_all();
+    unlock_state(s);
+}
+
+WorkerSlot& register_worker(SharedState* s, int slot_id) {
+    WorkerSlot& me = s->slots[slot_id];
+    lock_state(s);
+    me.liveness.register_self();
+    unlock_state(s);
+    cpu_accounting::count_into(&me.counts);
+    return me;
+}
+
+// Simulates a worker dying while it holds its read or write lock, once crash_at has passed
+void crash_if_due(std::chrono::steady_clock::time_point crash_at) {
+    if (std::chrono::steady_clock::now() >= crash_at) kill(getpid(), SIGKILL);
+}
+
+void reader_process(SharedState* s, int slot_id, std::chrono::steady_clock::time_point end,
+                    std::chrono::steady_clock::time_point crash_at) {
+    WorkerSlot& me = register_worker(s, slot_id);
+    long long reads = 0;
+    int observed = 0;
+
+    while (std::chrono::steady_clock::now() < end) {
+        read_lock(s, me);
+        observed = s->shared_memory;   // Zero-copy read straight out of the segment
+        crash_if_due(crash_at);
+        read_unlock(s, me);
+        reads++;
+        cpu_accounting::work();
+    }
+
+    lock_state(s);
+    s->reads += reads;
+    unlock_state(s);
+    (void)observed;
+}
+
+void writer_process(SharedState* s, int slot_id, std::chrono::steady_clock::time_point end,
+                    std::chrono::steady_clock::time_point crash_at) {
+    WorkerSlot& me = register_worker(s, slot_id);
+
+    while (std::chrono::steady_clock::now() < end) {
+        write_lock(s, me);
+        s->shared_memory += 1;   // Update shared memory
+        s->writes++;
+        crash_if_due(crash_at);
+        write_unlock(s, me);
+        cpu_accounting::work();
+    }
+}
+
+void upgrader_process(SharedState* s, int slot_id, std::chrono::steady_clock::time_point end,
+                      std::chrono::steady_clock::time_point crash_at) {
+    WorkerSlot& me = register_worker(s, slot_id);
+
+    while (std::chrono::steady_clock::now() < end) {
+        upgradable_lock(s, me);
+        int observed = s->shared_memory;
+        if (observed % 2 == 0) { // Decide to update based on the value read
+            upgrade(s, me);
+            s->shared_memory = observed + 1; // The value read is still current
+            s->writes++;
+            s->upgrades++;
+            crash_if_due(crash_at);
+            write_unlock(s, me);
+        } else {
+            crash_if_due(crash_at);
+            upgradable_unlock(s, me);
+        }
+        cpu_accounting::work();
+    }
+}
+
+// Usage: reader-writer-multiprocess [reader-first|writer-first|writer-first-collective|fair] [readers] [writers] [upgraders] [seconds] [crash]
+//   reader-first            - reader-first.cpp
+//   writer-first            - writer-first.cpp
+//   writer-first-collective - writer-first-collective-prefrence.cpp: the writer-first policy,
+//                             with every writer started before the readers
+//   fair                    - phase-fair alternation of readers and writers, the rule
+//                             reader-writer-fair.cpp approximates with its writer_turn flag
+// Upgraders take the upgradable read of rw_policy.h and write what they read plus one when it
+// is even. With crash, the first reader, writer and upgrader are killed halfway through the
+// run, on their next read or write, so recovery runs even when a policy starves one role.
+int main(int argc, char* argv[]) {
+    std::string policy_name = argc > 1 ? argv[1] : "reader-first";
+    int num_readers = argc > 2 ? std::stoi(argv[2]) : 4;
+    int num_writers = argc > 3 ? std::stoi(argv[3]) : 2;
+    int num_upgraders = argc > 4 ? std::stoi(argv[4]) : 2;
+    int simulation_duration = argc > 5 ? std::stoi(argv[5]) : 5; // Simulation time in seconds
+    bool crash = argc > 6 && std::string(argv[6]) == "crash";
+
+    rw_policy::Mode mode = rw_policy::READER_BIASED;
+    bool writers_first = false;
+    if (policy_name == "writer-first") {
+        mode = rw_policy::WRITER_BIASED;
+    } else if (policy_name == "writer-first-collective") {
+        mode = rw_policy::WRITER_BIASED;
+        writers_first = true;
+    } else if (policy_name == "fair") {
+        mode = rw_policy::PHASE_FAIR;
+    } else {
+        policy_name = "reader-first";
+    }
+
+    if (num_readers + num_writers + num_upgraders > MAX_WORKERS) {
+        atomicPrint("At most " + std::to_string(MAX_WORKERS) + " workers are supported", RED);
+        return 1;
+    }
+
+    SharedState* s = shm::create_segment<SharedState>();
+    if (!s) {
+        atomicPrint(std::string("mmap failed: ") + std::strerror(errno), RED);
+        return 1;
+    }
+    shm::init_robust_mutex(&s->state_mutex);
+    for (WorkerSlot& slot : s->slots) {
+        slot.liveness.init();
+    }
+    s->mode = mode;
+
+    atomicPrint("Policy " + policy_name + " (" + rw_policy::mode_name(mode) + "): " + std::to_string(num_readers)
+                + " reader, " + std::to_string(num_writers) + " writer and " + std::to_string(num_upgraders) + " upgrader processes for "
+                + std::to_string(simulation_duration) + "s", YELLOW);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::seconds(simulation_duration);
+    const auto crash_at = start + std::chrono::milliseconds(simulation_duration * 500);
+    const auto never = std::chrono::steady_clock::time_point::max();
+    const int workers = num_readers + num_writers + num_upgraders;
+    bool fork_failed = false;
+    std::map<pid_t, int> slot_of;   // Child pid -> slot, to match wait4()'s rusage to the worker
+
+    // Each child pins itself according to PLACEMENT before it starts working.
+    // Readers use slots [0, readers), writers the slots after them and upgraders the last
+    // ones, whatever the start order.
+    auto spawn_readers = [&] {
+        for (int i = 0; i < num_readers && !fork_failed; ++i) {
+            int slot_id = i;
+            pid_t pid = shm::spawn([&] {
+                placement::place_current(slot_id, workers);
+                reader_process(s, slot_id, end, crash && i == 0 ? crash_at : never);
+            });
+            fork_failed = pid == -1;
+            if (!fork_failed) slot_of[pid] = slot_id;
+        }
+    };
+    auto spawn_writers = [&] {
+        for (int i = 0; i < num_writers && !fork_failed; ++i) {
+            int slot_id = num_readers + i;
+            pid_t pid = shm::spawn([&] {
+                placement::place_current(slot_id, workers);
+                writer_process(s, slot_id, end, crash && i == 0 ? crash_at : never);
+            });
+            fork_failed = pid == -1;
+            if (!fork_failed) slot_of[pid] = slot_id;
+        }
+    };
+    auto spawn_upgraders = [&] {
+        for (int i = 0; i < num_upgraders && !fork_failed; ++i) {
+            int slot_id = num_readers + num_writers + i;
+            pid_t pid = shm::spawn([&] {
+                placement::place_current(slot_id, workers);
+                upgrader_process(s, slot_id, end, crash && i == 0 ? crash_at : never);
+            });
+            fork_failed = pid == -1;
+            if (!fork_failed) slot_of[pid] = slot_id;
+        }
+    };
+    if (writers_first) {
+        spawn_writers();
+        spawn_readers();
+    } else {
+        spawn_readers();
+        spawn_writers();
+    }
+    spawn_upgraders();
+    if (fork_failed) {
+        atomicPrint(std::string("fork failed: ") + std::strerror(errno) + "; running with the workers started so far", RED);
+    }
+
+    // wait4() hands back each child's CPU time and context switches
+    std::vector<cpu_accounting::Usage> usage(workers);
+    std::vector<bool> reaped(workers, false);
+    int status;
+    rusage ru;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, 0, &ru)) > 0) {
+        int slot_id = slot_of[pid];
+        usage[slot_id] = cpu_accounting::usage_of(ru);
+        reaped[slot_id] = true;
+    }
+
+    double seconds = simulation_duration;
+    atomicPrint("Reads:  " + std::to_string(s->reads) + " (" + std::to_string((long long)(s->reads / seconds)) + " ops/s)", GREEN);
+    atomicPrint("Writes: " + std::to_string(s->writes) + " (" + std::to_string((long long)(s->writes / seconds)) + " ops/s, "
+                + std::to_string(s->upgrades) + " by upgrading a read)", RED);
+    atomicPrint("Shared Memory: " + std::to_string(s->shared_memory)
+                + " | Holds recovered from dead processes: " + std::to_string(s->recovered), CYAN);
+
+    cpu_accounting::Ledger ledger;
+    for (int slot_id = 0; slot_id < workers; slot_id++) {
+        if (!reaped[slot_id]) continue;
+        std::string name = slot_id < num_readers ? "Reader " + std::to_string(slot_id + 1)
+                         : slot_id < num_readers + num_writers ? "Writer " + std::to_string(slot_id - num_readers + 1)
+                         : "Upgrader " + std::to_string(slot_id - num_readers - num_writers + 1);
+        ledger.record(name, usage[slot_id], s->slots[slot_id].counts);
+    }
+    for (const std::string& line : ledger.report(policy_name, "op")) {
+        atomicPrint(line, CYAN);
+    }
+    atomicPrint("Simulation complete!", YELLOW);
+
+    shm::destroy_segment(s);
+    return fork_failed ? 1 : 0;
+}
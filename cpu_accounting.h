@@ -0,0 +1,256 @@
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// CPU-efficiency accounting shared by the simulations.
+//
+// Every simulated actor opens a Scope at the top of its thread. The ledger then knows, per
+// thread:
+//   - CPU time and voluntary / involuntary context switches, from getrusage(RUSAGE_THREAD) when
+//     the thread finishes, or from its CPU clock and /proc/self/task/<tid>/status while it is
+//     still running (the readers-writers threads never return)
+//   - wakeups, and how many of them were wasted: the thread woke up (notification, timeout or
+//     spurious) and found it still could not make progress
+//   - units of work done (meals, reads, writes...)
+// report() turns that into CPU-us per unit of work, so strategies can be compared on
+// efficiency and not just on throughput.
+//
+// Usage in a thread:
+//   cpu_accounting::Scope account("Philosopher 1");
+//   cv.wait(lock, cpu_accounting::counted([&] { return ready; }));
+//   cpu_accounting::work();   // one meal / operation done
+//
+// Usage in a forked worker process: keep a Counters in the shared segment and call
+// count_into(&counters) in the child. The parent reaps the child with wait4(), which returns
+// its rusage, and passes both to Ledger::record().
+
+namespace cpu_accounting {
+
+struct Usage {
+    double cpu_us = 0;
+    long long voluntary = 0;     // Context switches because the thread blocked
+    long long involuntary = 0;   // Context switches because the thread was preempted
+};
+
+inline Usage usage_of(const rusage& ru) {
+    Usage usage;
+    usage.cpu_us = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+    usage.voluntary = ru.ru_nvcsw;
+    usage.involuntary = ru.ru_nivcsw;
+    return usage;
+}
+
+// Usage of the calling thread
+inline Usage self_usage() {
+    rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) != 0) return Usage();
+    return usage_of(ru);
+}
+
+// Usage of another, still running, thread of this process
+inline Usage live_usage(int tid, clockid_t clock) {
+    Usage usage;
+    timespec ts;
+    if (clock_gettime(clock, &ts) == 0) usage.cpu_us = ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+
+    std::ifstream status("/proc/self/task/" + std::to_string(tid) + "/status");
+    std::string key;
+    long long value;
+    while (status >> key) {
+        if (key == "voluntary_ctxt_switches:" && status >> value) usage.voluntary = value;
+        else if (key == "nonvoluntary_ctxt_switches:" && status >> value) usage.involuntary = value;
+    }
+    return usage;
+}
+
+// Kernel thread id of the calling thread ("/proc/thread-self" is its task directory)
+inline int current_tid() {
+    std::ifstream stat("/proc/thread-self/stat");
+    int tid = -1;
+    stat >> tid;
+    return tid;
+}
+
+// Work and wakeups of one actor. Lock-free atomics only, so it may live in a shared segment.
+struct Counters {
+    std::atomic<long long> work{0};
+    std::atomic<long long> wakeups{0};
+    std::atomic<long long> wasted{0};
+};
+
+struct Account : Counters {
+    std::string name;
+    int tid = -1;
+    clockid_t clock{};
+    bool finished = false;       // final is valid; guarded by the ledger's mutex
+    Usage final;
+};
+
+struct Totals {
+    int threads = 0;
+    Usage usage;
+    long long work = 0;
+    long long wakeups = 0;
+    long long wasted = 0;
+
+    double cpu_us_per_unit() const { return work ? usage.cpu_us / work : 0; }
+};
+
+class Ledger {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Account>> accounts;
+
+    // Must be called with mutex held
+    static Usage usage_of(const Account& account) {
+        return account.finished ? account.final : live_usage(account.tid, account.clock);
+    }
+
+public:
+    Account* open(const std::string& name) {
+        auto account = std::make_unique<Account>();
+        account->name = name;
+        account->tid = current_tid();
+        pthread_getcpuclockid(pthread_self(), &account->clock);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        accounts.push_back(std::move(account));
+        return accounts.back().get();
+    }
+
+    // Adds an actor that has already finished elsewhere, e.g. a child process reaped with wait4()
+    void record(const std::string& name, const Usage& usage, const Counters& counters) {
+        auto account = std::make_unique<Account>();
+        account->name = name;
+        account->finished = true;
+        account->final = usage;
+        account->work = counters.work.load();
+        account->wakeups = counters.wakeups.load();
+        account->wasted = counters.wasted.load();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        accounts.push_back(std::move(account));
+    }
+
+    void close(Account* account) {
+        Usage usage = self_usage();
+        std::lock_guard<std::mutex> lock(mutex);
+        account->final = usage;
+        account->finished = true;
+    }
+
+    Totals totals() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Totals totals;
+        for (const auto& account : accounts) {
+            Usage usage = usage_of(*account);
+            totals.threads++;
+            totals.usage.cpu_us += usage.cpu_us;
+            totals.usage.voluntary += usage.voluntary;
+            totals.usage.involuntary += usage.involuntary;
+            totals.work += account->work;
+            totals.wakeups += account->wakeups;
+            totals.wasted += account->wasted;
+        }
+        return totals;
+    }
+
+    // One line per thread, then the total for the strategy; unit is "meal", "op"...
+    std::vector<std::string> report(const std::string& strategy, const std::string& unit) {
+        std::vector<std::string> lines;
+        std::ostringstream header;
+        header << std::left << std::setw(16) << "thread" << std::right << std::setw(10) << "cpu ms"
+               << std::setw(8) << "vol cs" << std::setw(10) << "invol cs" << std::setw(9) << "wakeups"
+               << std::setw(8) << "wasted" << std::setw(8) << (unit + "s") << std::setw(14) << ("cpu-us/" + unit);
+        lines.push_back(header.str());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& account : accounts) {
+                Usage usage = usage_of(*account);
+                long long work = account->work;
+                std::ostringstream row;
+                row << std::left << std::setw(16) << account->name << std::right << std::fixed
+                    << std::setw(10) << std::setprecision(2) << usage.cpu_us / 1000
+                    << std::setw(8) << usage.voluntary << std::setw(10) << usage.involuntary
+                    << std::setw(9) << account->wakeups << std::setw(8) << account->wasted
+                    << std::setw(8) << work << std::setw(14) << std::setprecision(1) << (work ? usage.cpu_us / work : 0);
+                lines.push_back(row.str());
+            }
+        }
+
+        Totals t = totals();
+        std::ostringstream total;
+        total << strategy << ": " << std::fixed << std::setprecision(1) << t.cpu_us_per_unit() << " CPU-us per " << unit
+              << " over " << t.work << " " << unit << "s; " << t.wasted << " of " << t.wakeups << " wakeups wasted; "
+              << t.usage.voluntary << " voluntary / " << t.usage.involuntary << " involuntary context switches";
+        lines.push_back(total.str());
+        return lines;
+    }
+};
+
+// Ledger used by the programs that run a single strategy. Never destroyed: a thread still
+// running after main returns must not close its Scope on a destroyed ledger.
+inline Ledger& ledger() {
+    static Ledger* instance = new Ledger;
+    return *instance;
+}
+
+inline thread_local Counters* current = nullptr;
+
+// Accounts for the calling thread from construction until destruction
+class Scope {
+    Ledger& owner;
+    Account* account;
+
+public:
+    explicit Scope(const std::string& name) : Scope(ledger(), name) {}
+    Scope(Ledger& l, const std::string& name) : owner(l), account(l.open(name)) { current = account; }
+    ~Scope() {
+        owner.close(account);
+        current = nullptr;
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+// Counts the calling thread's work and wakeups into counters (for forked workers)
+inline void count_into(Counters* counters) {
+    current = counters;
+}
+
+// The calling thread finished one unit of work
+inline void work() {
+    if (current) current->work.fetch_add(1, std::memory_order_relaxed);
+}
+
+// The calling thread woke up; useful == false if it found nothing to do and must wait again
+inline void wakeup(bool useful) {
+    if (!current) return;
+    current->wakeups.fetch_add(1, std::memory_order_relaxed);
+    if (!useful) current->wasted.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Wraps a condition_variable::wait predicate: every check after the first one follows a
+// wakeup, which was wasted if the predicate is still false
+template <typename Predicate>
+auto counted(Predicate ready) {
+    return [ready, first = true]() mutable {
+        bool result = ready();
+        if (!first) wakeup(result);
+        first = false;
+        return result;
+    };
+}
+
+}  // namespace cpu_accounting
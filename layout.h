@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Memory layout of the dining philosophers' per-philosopher and per-fork state, picked at
+// compile time (e.g. g++ -DLAYOUT=LAYOUT_PADDED):
+//   LAYOUT_PACKED - the original layout: records and arrays packed back to back, so
+//                   neighbours share cache lines (default)
+//   LAYOUT_PADDED - one cache-line-aligned record per philosopher or fork (padded AoS)
+//   LAYOUT_SPLIT  - structure of arrays, split hot/cold: the fields that are scanned or polled
+//                   together stay packed in arrays of their own, and every mutex and
+//                   condition variable gets a line of its own
+//
+// The tables below are templates on the layout. The programs instantiate the one LAYOUT
+// picks, and Benchmarks/layout.cpp instantiates all three side by side, so the benchmark
+// measures exactly the layouts the programs are built with.
+
+#define LAYOUT_PACKED 0
+#define LAYOUT_PADDED 1
+#define LAYOUT_SPLIT 2
+#ifndef LAYOUT
+#define LAYOUT LAYOUT_PACKED
+#endif
+
+namespace layout {
+
+constexpr std::size_t cache_line = 64;
+
+constexpr const char* name(int l) {
+    return l == LAYOUT_PADDED ? "padded" : l == LAYOUT_SPLIT ? "split" : "packed";
+}
+
+// Aligns a single hot object (a table-wide mutex) to a line of its own unless packed
+#if LAYOUT == LAYOUT_PACKED
+#define CACHE_ALIGNED
+#else
+#define CACHE_ALIGNED alignas(layout::cache_line)
+#endif
+
+// One T, on a cache line of its own unless the layout is packed
+template <int L, typename T>
+struct alignas(L == LAYOUT_PACKED ? alignof(T) : cache_line) Cell {
+    T value;
+};
+
+// One flag per philosopher (queue.cpp): bit-packed vector<bool> when packed, one byte per
+// flag when split, one cache line per flag when padded
+struct alignas(cache_line) PaddedFlag {
+    bool value;
+    PaddedFlag(bool v = false) : value(v) {}
+    operator bool() const { return value; }
+};
+
+template <int L>
+using FlagArray = typename std::conditional<L == LAYOUT_PACKED, std::vector<bool>,
+                  typename std::conditional<L == LAYOUT_PADDED, std::vector<PaddedFlag>,
+                                            std::vector<unsigned char>>::type>::type;
+
+// State and wakeup condition variable of each philosopher (dijkstra-tannenbaum.cpp).
+// Packed and split keep the states test() scans in one int array; padded keeps state and
+// cv together in one record per line.
+template <int L, typename Cv>
+class PhilosopherTable {
+    struct Record {
+        int state;
+        Cv cv;
+    };
+
+    std::vector<int> states;                        // Packed and split
+    std::unique_ptr<Cell<L, Cv>[]> cvs;             // Packed and split
+    std::unique_ptr<Cell<L, Record>[]> records;     // Padded
+
+public:
+    PhilosopherTable(int n, int initial_state)
+        : states(L == LAYOUT_PADDED ? 0 : n, initial_state),
+          cvs(L == LAYOUT_PADDED ? nullptr : new Cell<L, Cv>[n]),
+          records(L == LAYOUT_PADDED ? new Cell<L, Record>[n] : nullptr) {
+        for (int i = 0; L == LAYOUT_PADDED && i < n; i++) records[i].value.state = initial_state;
+    }
+
+    int& state(int i) { return L == LAYOUT_PADDED ? records[i].value.state : states[i]; }
+    Cv& cv(int i) { return L == LAYOUT_PADDED ? records[i].value.cv : cvs[i].value; }
+};
+
+// Owner, dirty flag, mutex and channel of each fork (chandy-misra.cpp).
+// Packed and padded keep one record per fork. Split is a real structure of arrays: the
+// owner/dirty flags request() polls are packed in arrays of their own, apart from the
+// padded mutexes and channels that philosophers block on.
+template <int L, typename Mutex, typename Channel>
+class ForkTable {
+    struct Record {
+        int owner = 0;
+        bool dirty = true;
+        Mutex mutex;
+        Channel channel;
+    };
+
+    std::unique_ptr<Cell<L, Record>[]> forks;
+
+public:
+    explicit ForkTable(int n) : forks(new Cell<L, Record>[n]) {}
+
+    int& owner(int i) { return forks[i].value.owner; }
+    bool& dirty(int i) { return forks[i].value.dirty; }
+    Mutex& mutex(int i) { return forks[i].value.mutex; }
+    Channel& channel(int i) { return forks[i].value.channel; }
+};
+
+template <typename Mutex, typename Channel>
+class ForkTable<LAYOUT_SPLIT, Mutex, Channel> {
+    std::unique_ptr<int[]> owners;
+    std::unique_ptr<bool[]> dirty_flags;
+    std::unique_ptr<Cell<LAYOUT_SPLIT, Mutex>[]> mutexes;
+    std::unique_ptr<Cell<LAYOUT_SPLIT, Channel>[]> channels;
+
+public:
+    explicit ForkTable(int n)
+        : owners(new int[n]()), dirty_flags(new bool[n]), mutexes(new Cell<LAYOUT_SPLIT, Mutex>[n]),
+          channels(new Cell<LAYOUT_SPLIT, Channel>[n]) {
+        for (int i = 0; i < n; i++) dirty_flags[i] = true;
+    }
+
+    int& owner(int i) { return owners[i]; }
+    bool& dirty(int i) { return dirty_flags[i]; }
+    Mutex& mutex(int i) { return mutexes[i].value; }
+    Channel& channel(int i) { return channels[i].value; }
+};
+
+}  // namespace layout
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+// Topology-aware thread placement shared by all the simulations.
+//
+// The CPU topology is read from /sys/devices/system/cpu (package, L3 and L2 domains, core,
+// SMT siblings), restricted to the CPUs this process may run on. The policy comes from the
+// PLACEMENT environment variable:
+//   none     - leave placement to the OS (default, same as before)
+//   compact  - fill the closest CPUs first: SMT siblings, then the same L2, then the same L3
+//   scatter  - spread actors over L3 domains / packages, one per core before using siblings
+//   neighbor - cut the ring of actors into contiguous arcs, one per L3 domain, over the
+//              fewest domains that hold it, so actors that share a fork or lock share a
+//              cache; each arc is spread over its domain's L2s, one per core first
+//
+// e.g. PLACEMENT=neighbor ./queue
+
+namespace placement {
+
+enum class Policy { NONE, COMPACT, SCATTER, NEIGHBOR };
+
+struct Cpu {
+    int id = 0;
+    int package = 0;
+    int l3 = 0;       // First CPU sharing this CPU's L3, or the package if unknown
+    int l2 = 0;       // First CPU sharing this CPU's L2, or the core if unknown
+    int core = 0;
+    int sibling = 0;  // Position among the SMT siblings of its core
+};
+
+inline int read_int(const std::string& path, int fallback) {
+    std::ifstream in(path);
+    int value;
+    return (in >> value) ? value : fallback;
+}
+
+// A cache domain is identified by the first CPU in its shared_cpu_list ("0-3,8-11" -> 0)
+inline int read_cache_domain(int cpu, int level, int fallback) {
+    for (int index = 0; index < 8; index++) {
+        std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cache/index" + std::to_string(index) + "/";
+        int cache_level = read_int(dir + "level", -1);
+        if (cache_level == -1) break;
+        if (cache_level == level) return read_int(dir + "shared_cpu_list", fallback);
+    }
+    return fallback;
+}
+
+class Topology {
+public:
+    std::vector<Cpu> cpus;
+
+    static Topology read() {
+        Topology topology;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return topology;
+
+        for (int id = 0; id < CPU_SETSIZE; id++) {
+            if (!CPU_ISSET(id, &allowed)) continue;
+            std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            Cpu cpu;
+            cpu.id = id;
+            cpu.package = read_int(dir + "physical_package_id", 0);
+            cpu.core = read_int(dir + "core_id", id);
+            cpu.l3 = read_cache_domain(id, 3, cpu.package);
+            cpu.l2 = read_cache_domain(id, 2, cpu.core);
+            topology.cpus.push_back(cpu);
+        }
+
+        std::map<std::pair<int, int>, int> siblings_seen;
+        for (Cpu& cpu : topology.cpus) {
+            cpu.sibling = siblings_seen[{cpu.package, cpu.core}]++;
+        }
+        return topology;
+    }
+
+    // CPUs ordered so that neighbours in the list share as much cache as possible
+    std::vector<int> compact_order() const {
+        std::vector<Cpu> sorted = cpus;
+        std::sort(sorted.begin(), sorted.end(), [](const Cpu& a, const Cpu& b) {
+            return std::tie(a.package, a.l3, a.l2, a.core, a.id) < std::tie(b.package, b.l3, b.l2, b.core, b.id);
+        });
+        std::vector<int> order;
+        for (const Cpu& cpu : sorted) order.push_back(cpu.id);
+        return order;
+    }
+
+    // CPUs ordered round-robin over L3 domains, each domain handing out one CPU per core first
+    std::vector<int> scatter_order() const {
+        std::map<std::pair<int, int>, std::vector<Cpu>> domains;
+        for (const Cpu& cpu : cpus) domains[{cpu.package, cpu.l3}].push_back(cpu);
+        for (auto& [key, members] : domains) {
+            std::sort(members.begin(), members.end(), [](const Cpu& a, const Cpu& b) {
+                return std::tie(a.sibling, a.l2, a.core, a.id) < std::tie(b.sibling, b.l2, b.core, b.id);
+            });
+        }
+
+        std::vector<int> order;
+        for (size_t round = 0; order.size() < cpus.size(); round++) {
+            for (auto& [key, members] : domains) {
+                if (round < members.size()) order.push_back(members[round].id);
+            }
+        }
+        return order;
+    }
+
+    // CPU of each of `actors` actors around a ring, for NEIGHBOR.
+    // The ring is cut into contiguous arcs over the fewest L3 domains that have a CPU for
+    // every actor (all of them when there are more actors than CPUs), each arc as long as its
+    // share of those domains' CPUs. The ring is rotated by half the first arc, so actors n-1
+    // and 0 sit in the middle of it: a ring cut into k arcs crosses domains exactly k times,
+    // and the closure is never one of them. Within its domain an arc is cut again over the
+    // L2s, which hand out one CPU per core before SMT siblings. When there are more actors
+    // than CPUs, consecutive actors share a CPU.
+    std::vector<int> ring_cpus(int actors) const {
+        // L3 domains in compact order, each split into its L2 groups
+        std::vector<Cpu> sorted = cpus;
+        std::sort(sorted.begin(), sorted.end(), [](const Cpu& a, const Cpu& b) {
+            return std::tie(a.package, a.l3, a.l2, a.sibling, a.core, a.id) < std::tie(b.package, b.l3, b.l2, b.sibling, b.core, b.id);
+        });
+        std::vector<std::vector<std::vector<int>>> domains;
+        std::vector<int> domain_size;
+        for (size_t i = 0; i < sorted.size(); i++) {
+            const Cpu& cpu = sorted[i];
+            bool new_domain = i == 0 || cpu.package != sorted[i - 1].package || cpu.l3 != sorted[i - 1].l3;
+            if (new_domain) {
+                domains.emplace_back();
+                domain_size.push_back(0);
+            }
+            if (new_domain || cpu.l2 != sorted[i - 1].l2) domains.back().emplace_back();
+            domains.back().back().push_back(cpu.id);
+            domain_size.back()++;
+        }
+
+        size_t used = 0;
+        int capacity = 0;
+        while (used < domains.size() && capacity < actors) capacity += domain_size[used++];
+
+        // Splits `count` positions over parts of the given sizes, in proportion
+        auto split = [](int count, const std::vector<int>& sizes, int total) {
+            std::vector<int> starts;
+            int seen = 0;
+            for (int size : sizes) {
+                starts.push_back((long long)count * seen / total);
+                seen += size;
+            }
+            starts.push_back(count);
+            return starts;
+        };
+
+        std::vector<int> arc_start = split(actors, std::vector<int>(domain_size.begin(), domain_size.begin() + used), capacity);
+        int rotation = used > 1 ? (arc_start[1] - arc_start[0]) / 2 : 0;
+
+        std::vector<int> cpu_of(actors, -1);
+        for (size_t d = 0; d < used; d++) {
+            const std::vector<std::vector<int>>& groups = domains[d];
+            std::vector<int> group_size;
+            for (const std::vector<int>& group : groups) group_size.push_back(group.size());
+            int length = arc_start[d + 1] - arc_start[d];
+            std::vector<int> group_start = split(length, group_size, domain_size[d]);
+
+            for (size_t g = 0; g < groups.size(); g++) {
+                int size = groups[g].size();
+                int members = group_start[g + 1] - group_start[g];
+                for (int j = 0; j < members; j++) {
+                    int position = arc_start[d] + group_start[g] + j;
+                    int actor = (position - rotation + actors) % actors;
+                    cpu_of[actor] = groups[g][members <= size ? j : (long long)j * size / members];
+                }
+            }
+        }
+        return cpu_of;
+    }
+
+    // Number of distinct L3 domains, for reporting
+    int l3_domains() const {
+        std::vector<std::pair<int, int>> seen;
+        for (const Cpu& cpu : cpus) seen.push_back({cpu.package, cpu.l3});
+        std::sort(seen.begin(), seen.end());
+        return std::unique(seen.begin(), seen.end()) - seen.begin();
+    }
+};
+
+inline Policy parse_policy(const std::string& name) {
+    if (name == "compact") return Policy::COMPACT;
+    if (name == "scatter") return Policy::SCATTER;
+    if (name == "neighbor") return Policy::NEIGHBOR;
+    return Policy::NONE;
+}
+
+inline const char* policy_name(Policy policy) {
+    switch (policy) {
+        case Policy::COMPACT: return "compact";
+        case Policy::SCATTER: return "scatter";
+        case Policy::NEIGHBOR: return "neighbor";
+        default: return "none";
+    }
+}
+
+inline Policy policy_from_env() {
+    const char* value = std::getenv("PLACEMENT");
+    return parse_policy(value ? value : "none");
+}
+
+// CPU for actor `actor` out of `actors` (actors are numbered around the table), -1 for none
+inline int cpu_for(Policy policy, const Topology& topology, int actor, int actors) {
+    if (policy == Policy::NONE || topology.cpus.empty() || actors <= 0) return -1;
+
+    if (policy == Policy::SCATTER) {
+        std::vector<int> order = topology.scatter_order();
+        return order[actor % order.size()];
+    }
+
+    std::vector<int> order = topology.compact_order();
+    if (policy == Policy::COMPACT) {
+        return order[actor % order.size()];
+    }
+    // NEIGHBOR: unlike compact, which stacks SMT siblings before using the next core, leaves
+    // the last domain it reaches partly used, and wraps actor n-1 and actor 0 onto different
+    // domains, see Topology::ring_cpus
+    return topology.ring_cpus(actors)[actor % actors];
+}
+
+inline bool pin(pthread_t thread, int cpu) {
+    if (cpu < 0) return false;
+    cpu_set_t target;
+    CPU_ZERO(&target);
+    CPU_SET(cpu, &target);
+    return pthread_setaffinity_np(thread, sizeof(target), &target) == 0;
+}
+
+// Pins a thread according to the PLACEMENT policy; does nothing when it is unset
+inline void place(std::thread& thread, int actor, int actors) {
+    static const Policy policy = policy_from_env();
+    if (policy == Policy::NONE) return;
+    static const Topology topology = Topology::read();
+    pin(thread.native_handle(), cpu_for(policy, topology, actor, actors));
+}
+
+// Same, for the calling thread (or a freshly forked process)
+inline void place_current(int actor, int actors) {
+    static const Policy policy = policy_from_env();
+    if (policy == Policy::NONE) return;
+    static const Topology topology = Topology::read();
+    pin(pthread_self(), cpu_for(policy, topology, actor, actors));
+}
+
+}  // namespace placement
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// MCS and CLH queue locks, usable wherever the simulations take an exclusive lock.
+//
+// Both are FIFO: waiters line up in a queue of nodes and each one waits on *its own* node
+// (MCS: its node, CLH: its predecessor's node), so a release touches exactly one waiter's
+// cache line instead of making every waiter re-read the lock word. A waiter spins briefly
+// and then parks on its node's own mutex/condition variable, so oversubscribed runs do not
+// burn CPU.
+//
+// Both meet BasicLockable (lock/unlock), so they drop into std::lock_guard / std::unique_lock
+// and wait with std::condition_variable_any. The node for the current holder is kept in the
+// lock itself, so unlock() may be called from a different thread than lock(), as the
+// reader-preference programs do with resource_mutex.
+//
+// Pick the implementation at compile time, e.g. g++ -DEXCLUSIVE_LOCK=LOCK_MCS:
+//   LOCK_STD - std::mutex (default, same as before)
+//   LOCK_MCS - MCS queue lock
+//   LOCK_CLH - CLH queue lock
+
+#define LOCK_STD 0
+#define LOCK_MCS 1
+#define LOCK_CLH 2
+#ifndef EXCLUSIVE_LOCK
+#define EXCLUSIVE_LOCK LOCK_STD
+#endif
+
+namespace queue_locks {
+
+struct alignas(64) Node {
+    std::atomic<Node*> next{nullptr};
+    std::atomic<uint32_t> state{0};   // RELEASED, LOCKED or PARKED
+    std::mutex park_mutex;            // Only used once the waiter gives up spinning
+    std::condition_variable park_cv;
+};
+
+enum : uint32_t { RELEASED = 0, LOCKED = 1, PARKED = 2 };
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Waits until node->state is RELEASED: spin a little, then sleep on the node
+inline void wait_released(Node* node) {
+    for (int spins = 0; spins < 128; spins++) {
+        if (node->state.load(std::memory_order_acquire) == RELEASED) return;
+        cpu_relax();
+    }
+    std::unique_lock<std::mutex> lock(node->park_mutex);
+    uint32_t expected = LOCKED;
+    if (!node->state.compare_exchange_strong(expected, PARKED, std::memory_order_acquire)) return;
+    node->park_cv.wait(lock, [node] { return node->state.load(std::memory_order_acquire) == RELEASED; });
+}
+
+// Hands the lock to whoever waits on node, waking it if it parked. A parked waiter only sees
+// RELEASED under park_mutex, so it cannot reuse the node while we are still notifying it.
+inline void release(Node* node) {
+    uint32_t expected = LOCKED;
+    if (node->state.compare_exchange_strong(expected, RELEASED, std::memory_order_release)) return;
+    std::lock_guard<std::mutex> lock(node->park_mutex);
+    node->state.store(RELEASED, std::memory_order_release);
+    node->park_cv.notify_one();
+}
+
+// Per-thread cache of nodes so an acquisition does not hit malloc
+class NodePool {
+    std::vector<Node*> free_nodes;
+
+public:
+    ~NodePool() {
+        for (Node* node : free_nodes) delete node;
+    }
+
+    Node* get() {
+        if (free_nodes.empty()) return new Node;
+        Node* node = free_nodes.back();
+        free_nodes.pop_back();
+        return node;
+    }
+
+    void put(Node* node) { free_nodes.push_back(node); }
+};
+
+inline NodePool& node_pool() {
+    thread_local NodePool pool;
+    return pool;
+}
+
+// MCS: the queue is linked forward; each waiter waits on its own node and the holder
+// releases its successor directly
+class McsLock {
+    std::atomic<Node*> tail{nullptr};
+    Node* holder = nullptr;
+
+public:
+    McsLock() = default;
+    McsLock(const McsLock&) = delete;
+    McsLock& operator=(const McsLock&) = delete;
+
+    void lock() {
+        Node* node = node_pool().get();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->state.store(LOCKED, std::memory_order_relaxed);
+
+        Node* predecessor = tail.exchange(node, std::memory_order_acq_rel);
+        if (predecessor) {
+            predecessor->next.store(node, std::memory_order_release);
+            wait_released(node);
+        }
+        holder = node;
+    }
+
+    bool try_lock() {
+        Node* node = node_pool().get();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* expected = nullptr;
+        if (!tail.compare_exchange_strong(expected, node, std::memory_order_acq_rel)) {
+            node_pool().put(node);
+            return false;
+        }
+        holder = node;
+        return true;
+    }
+
+    void unlock() {
+        Node* node = holder;
+        Node* successor = node->next.load(std::memory_order_acquire);
+        if (!successor) {
+            Node* expected = node;
+            if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                node_pool().put(node);
+                return;
+            }
+            // A successor swapped itself in but has not linked up yet
+            while (!(successor = node->next.load(std::memory_order_acquire))) {
+                cpu_relax();
+            }
+        }
+        release(successor);
+        node_pool().put(node);
+    }
+};
+
+// CLH: the queue is linked implicitly; each waiter waits on its predecessor's node and
+// takes that node over once it has the lock
+class ClhLock {
+    std::atomic<Node*> tail;
+    Node* holder = nullptr;
+
+public:
+    ClhLock() : tail(new Node) {}   // Starts with a released dummy node
+    ClhLock(const ClhLock&) = delete;
+    ClhLock& operator=(const ClhLock&) = delete;
+
+    ~ClhLock() { delete tail.load(); }
+
+    void lock() {
+        Node* node = node_pool().get();
+        node->state.store(LOCKED, std::memory_order_relaxed);
+
+        Node* predecessor = tail.exchange(node, std::memory_order_acq_rel);
+        wait_released(predecessor);
+        node_pool().put(predecessor);   // Nobody else refers to it any more
+        holder = node;
+    }
+
+    void unlock() {
+        // The successor (or the next locker) takes the node over
+        release(holder);
+    }
+};
+
+// Condition variable that can wait with a given lock type
+template <typename Lock>
+using ConditionFor = typename std::conditional<std::is_same<Lock, std::mutex>::value, std::condition_variable,
+                                               std::condition_variable_any>::type;
+
+#if EXCLUSIVE_LOCK == LOCK_MCS
+using ExclusiveLock = McsLock;
+using ExclusiveCondition = ConditionFor<McsLock>;
+constexpr const char* exclusive_lock_name = "mcs";
+#elif EXCLUSIVE_LOCK == LOCK_CLH
+using ExclusiveLock = ClhLock;
+using ExclusiveCondition = ConditionFor<ClhLock>;
+constexpr const char* exclusive_lock_name = "clh";
+#else
+using ExclusiveLock = std::mutex;
+using ExclusiveCondition = ConditionFor<std::mutex>;
+constexpr const char* exclusive_lock_name = "std::mutex";
+#endif
+
+}  // namespace queue_locks
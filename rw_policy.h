@@ -0,0 +1,115 @@
+#pragma once
+
+// Admission rules of the reader-writer policies, shared by the adaptive lock and the
+// multi-process lock:
+//   READER_BIASED - readers enter whenever no writer is writing (reader-first.cpp)
+//   WRITER_BIASED - readers hold back while a writer waits (writer-first.cpp)
+//   PHASE_FAIR    - readers and writers alternate: readers that were waiting when a write
+//                   finished go next, then the waiting writer, and so on
+// Every mode also has an upgradable read: one upgradable reader at a time is admitted like a
+// reader, and may later turn its read hold into a write hold in place. While the upgrade is
+// pending no new reader enters, so the other readers drain and no writer gets in between.
+// The rules only look at Counts, which is plain data so it can sit in a shared-memory
+// segment. The caller keeps Counts consistent under its own mutex.
+
+namespace rw_policy {
+
+enum Mode { READER_BIASED = 0, WRITER_BIASED = 1, PHASE_FAIR = 2 };
+
+inline const char* mode_name(Mode mode) {
+    return mode == READER_BIASED ? "reader-biased" : mode == WRITER_BIASED ? "writer-biased" : "phase-fair";
+}
+
+struct Counts {
+    int active_readers = 0;
+    bool writer_active = false;
+    int waiting_readers = 0;
+    int waiting_writers = 0;
+
+    // Phase-fair bookkeeping: write_phase is bumped after every write, and reader_turn
+    // holds writers back until the readers that waited through that write have entered
+    unsigned write_phase = 0;
+    int reader_turn = 0;
+
+    // The upgradable reader, counted in active_readers while it reads, and whether it is
+    // waiting for the other readers to drain
+    bool upgrader_active = false;
+    bool upgrade_pending = false;
+};
+
+// arrival_phase is write_phase as the reader saw it when it started waiting
+inline bool reader_may_enter(Mode mode, const Counts& c, unsigned arrival_phase) {
+    if (c.writer_active || c.upgrade_pending) return false;
+    switch (mode) {
+        case WRITER_BIASED:
+            return c.waiting_writers == 0;
+        case PHASE_FAIR:
+            return c.waiting_writers == 0 || arrival_phase != c.write_phase;
+        default:
+            return true;
+    }
+}
+
+inline bool writer_may_enter(Mode mode, const Counts& c) {
+    if (c.writer_active || c.active_readers > 0) return false;
+    switch (mode) {
+        case READER_BIASED:
+            return c.waiting_readers == 0;
+        case PHASE_FAIR:
+            return c.reader_turn == 0;
+        default:
+            return true;
+    }
+}
+
+// An upgradable reader waits as a reader, and also for the upgrader slot
+inline bool upgrader_may_enter(Mode mode, const Counts& c, unsigned arrival_phase) {
+    return !c.upgrader_active && reader_may_enter(mode, c, arrival_phase);
+}
+
+// The upgrader may write once it is the only reader left
+inline bool upgrade_may_complete(const Counts& c) {
+    return c.active_readers == 1;
+}
+
+// A waiting reader was admitted
+inline void reader_entered(Counts& c, unsigned arrival_phase) {
+    c.waiting_readers--;
+    if (c.reader_turn > 0 && arrival_phase != c.write_phase) c.reader_turn--;
+    c.active_readers++;
+}
+
+// A waiting upgradable reader was admitted
+inline void upgrader_entered(Counts& c, unsigned arrival_phase) {
+    reader_entered(c, arrival_phase);
+    c.upgrader_active = true;
+}
+
+// The upgradable reader finished without writing
+inline void upgrader_left(Counts& c) {
+    c.active_readers--;
+    c.upgrader_active = false;
+}
+
+// The upgrader's read hold became a write hold; it releases it with write_finished()
+inline void upgrade_completed(Counts& c) {
+    c.active_readers--;
+    c.upgrader_active = false;
+    c.upgrade_pending = false;
+    c.writer_active = true;
+}
+
+// A waiting writer was admitted
+inline void writer_entered(Counts& c) {
+    c.waiting_writers--;
+    c.writer_active = true;
+}
+
+inline void write_finished(Mode mode, Counts& c) {
+    c.writer_active = false;
+    c.write_phase++;
+    // In phase-fair mode the readers that waited through this write go before the next writer
+    c.reader_turn = mode == PHASE_FAIR ? c.waiting_readers : 0;
+}
+
+}  // namespace rw_policy
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <new>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Building blocks for the multi-process programs. Everything here is placed in one mmap'ed
+// MAP_SHARED segment, so every forked worker sees the same objects:
+//   - robust, process-shared pthread mutexes: if a process dies while holding one, the next
+//     locker gets EOWNERDEAD and repairs the state it protects
+//   - Channel: the process-shared counterpart of sync_channel, a non-private futex word that
+//     is bumped on every notification
+//   - Liveness: a robust mutex each worker holds for its whole life; trying it tells whether
+//     the worker is dead, so holds it left behind can be released
+
+namespace shm {
+
+inline long futex(std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+inline void init_robust_mutex(pthread_mutex_t* mutex) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+// Locks a robust mutex; returns true if its previous owner died while holding it, in which
+// case the caller must repair the state the mutex protects
+inline bool lock_robust(pthread_mutex_t* mutex) {
+    if (pthread_mutex_lock(mutex) != EOWNERDEAD) return false;
+    pthread_mutex_consistent(mutex);
+    return true;
+}
+
+struct Channel {
+    std::atomic<uint32_t> sequence{0};
+
+    // Read before dropping the lock that guards the condition, then pass to wait()
+    uint32_t snapshot() const { return sequence.load(); }
+
+    // Sleeps until notified after `seen` was taken, or for at most timeout_ms.
+    // Returns false on timeout.
+    bool wait(uint32_t seen, long timeout_ms) {
+        timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000 * 1000};
+        long rc = futex(&sequence, FUTEX_WAIT, seen, &timeout);
+        return !(rc == -1 && errno == ETIMEDOUT);
+    }
+
+    void notify_all() {
+        sequence.fetch_add(1);
+        futex(&sequence, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+};
+
+struct Liveness {
+    pthread_mutex_t alive_mutex;   // Held by the worker for its whole life
+    pid_t pid = 0;                 // 0 while the slot is unused
+
+    void init() { init_robust_mutex(&alive_mutex); }
+
+    // Called by the worker itself, first thing after fork()
+    void register_self() {
+        pthread_mutex_lock(&alive_mutex);
+        pid = getpid();
+    }
+
+    // True once the worker has died; only reports each death once. Callers must serialize
+    // calls for the same worker (the programs hold their state mutex).
+    bool died() {
+        if (pid == 0) return false;
+        int rc = pthread_mutex_trylock(&alive_mutex);
+        if (rc == EBUSY) return false;
+        // EOWNERDEAD, or 0 if a checker died after repairing the mutex but before clearing pid
+        if (rc == EOWNERDEAD) pthread_mutex_consistent(&alive_mutex);
+        pthread_mutex_unlock(&alive_mutex);
+        pid = 0;
+        return true;
+    }
+};
+
+// Maps an anonymous shared segment and constructs a T in it; nullptr if mmap fails
+template <typename T>
+T* create_segment() {
+    void* segment = mmap(nullptr, sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (segment == MAP_FAILED) return nullptr;
+    return new (segment) T();
+}
+
+template <typename T>
+void destroy_segment(T* segment) {
+    munmap(segment, sizeof(T));
+}
+
+// Forks a worker that runs body() and exits; returns the child's pid, or -1 if fork failed
+template <typename Body>
+pid_t spawn(Body body) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        body();
+        _exit(0);
+    }
+    return pid;
+}
+
+}  // namespace shm